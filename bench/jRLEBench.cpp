@@ -0,0 +1,381 @@
+/**
+ * Throughput benchmarks for each stage of jRLE en/decoding.
+ *
+ * Every stage is run over synthetic corpora with controlled run length
+ * distributions, so that a change to one stage can be measured in
+ * isolation, and against inputs that exercise each of the #-cases:
+ * - singletons: no two adjacent chars are the same
+ * - geometric: run lengths follow a geometric distribution, mean 4
+ * - long: runs of 64 to 4096 chars, always long sequences (#-case a)
+ * - medium: runs of 10 to 99 chars, so every count has two digits
+ * - digits: geometric runs of digit chars (#-case c)
+ * - hashes: geometric runs, mostly of '#' chars (#-case b)
+ *
+ * The token pipeline is measured with std::string tokens and Run tokens,
+ * and tokenizing is also measured into views and into an arena. The codec
+ * is also measured specialized for corpora with no digits or '#' chars,
+ * and against the hybrid literal/run format. The batch decoder, and
+ * validating encoded text without decoding it, are measured alongside
+ * decoding, as is consuming the decoded text lazily, with forEachRun() and
+ * DecodedView.
+ *
+ * Each benchmark reports:
+ * - bytes_per_second: MB of unencoded text processed per second, for every
+ *   stage, including those that take encoded input
+ * - time/run: time taken per run in the corpus
+ * - allocs/MB: heap allocations made per MB of unencoded text
+ *
+ * Uses Google Benchmark, so accepts its usual flags, for example:
+ * jRLEBench --benchmark_filter=decode
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLE.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <memory_resource>
+#include <new>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// The length in bytes of the unencoded text of each corpus
+constexpr std::size_t corpusSize = 1 << 22;
+
+// The number of heap allocations made so far, by any thread
+static std::atomic<std::size_t> allocationCount{0};
+
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size != 0 ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+
+/**
+ * The standard format, for text known to contain no digits or '#' chars.
+ */
+struct LettersPolicy : DefaultRLEPolicy {
+    static constexpr bool inputHasDigits = false;
+    static constexpr bool inputHasMarkers = false;
+};
+
+
+/**
+ * Synthetic unencoded text, along with its representation after each stage,
+ * so that every stage can be measured on its own.
+ */
+struct Corpus {
+    std::string name;
+    std::string text;
+    std::size_t runs;
+    std::vector<std::string> dTokens;
+    std::vector<std::string> eTokens;
+    std::string encoded;
+    // eTokens as read back from the encoded text, which differ from those
+    // produced by encodeTokens() in dropping the '#' prefix
+    std::vector<std::string> readTokens;
+    std::vector<Run> runTokens;
+    std::string hybridEncoded;
+};
+
+
+/**
+ * Generate unencoded text from runs of the given lengths and chars.
+ *
+ * @param nextLength generates the length of each run
+ * @param nextChar generates the char of each run
+ * @return text of exactly corpusSize chars
+ */
+static std::string generateText(
+        const std::function<std::size_t()>& nextLength,
+        const std::function<char()>& nextChar) {
+    std::string text;
+    text.reserve(corpusSize);
+    char prev{0};
+    while (text.length() < corpusSize) {
+        // Adjacent runs of the same char would merge into one
+        char c;
+        do {
+            c = nextChar();
+        } while (c == prev);
+        text.append(nextLength(), c);
+        prev = c;
+    }
+    text.resize(corpusSize);
+    return text;
+}
+
+
+/**
+ * Generate a corpus, and its representation after each stage.
+ *
+ * @param name the name to report the corpus under
+ * @param nextLength generates the length of each run
+ * @param nextChar generates the char of each run
+ * @return the corpus
+ */
+static Corpus makeCorpus(const std::string& name,
+        const std::function<std::size_t()>& nextLength,
+        const std::function<char()>& nextChar) {
+    Corpus corpus;
+    corpus.name = name;
+    corpus.text = generateText(nextLength, nextChar);
+    corpus.dTokens = tokenizeUnencoded(corpus.text);
+    corpus.runs = corpus.dTokens.size();
+    corpus.eTokens = encodeTokens(corpus.dTokens);
+    corpus.encoded = vectorConcatenate(corpus.eTokens);
+    corpus.readTokens = tokenizeEncoded(corpus.encoded);
+    tokenizeUnencoded(corpus.text, corpus.runTokens);
+    OutputBuffer hybrid;
+    encodeHybrid(corpus.text, hybrid);
+    corpus.hybridEncoded = hybrid.str();
+    return corpus;
+}
+
+
+/**
+ * @return every corpus, generated on first use
+ */
+static const std::vector<Corpus>& corpora() {
+    static const std::vector<Corpus> all = [] {
+        // A fixed seed, so that results are comparable between runs
+        std::mt19937_64 rng{ 20200101 };
+        std::geometric_distribution<std::size_t> geometric{ 0.25 };
+        std::uniform_int_distribution<std::size_t> longLength{ 64, 4096 };
+        std::uniform_int_distribution<std::size_t> mediumLength{ 10, 99 };
+        std::uniform_int_distribution<int> letter{ 'a', 'z' };
+        std::uniform_int_distribution<int> digit{ '0', '9' };
+        std::uniform_int_distribution<int> percent{ 0, 99 };
+
+        auto one = [] { return std::size_t{1}; };
+        auto geometricLength = [&] { return geometric(rng) + 1; };
+        auto letters = [&] { return static_cast<char>(letter(rng)); };
+
+        std::vector<Corpus> made;
+        made.push_back(makeCorpus("singletons", one, letters));
+        made.push_back(makeCorpus("geometric", geometricLength, letters));
+        made.push_back(makeCorpus("long",
+            [&] { return longLength(rng); }, letters));
+        made.push_back(makeCorpus("medium",
+            [&] { return mediumLength(rng); }, letters));
+        made.push_back(makeCorpus("digits", geometricLength,
+            [&] { return static_cast<char>(digit(rng)); }));
+        made.push_back(makeCorpus("hashes", geometricLength, [&] {
+            return percent(rng) < 50 ? '#' : static_cast<char>(letter(rng));
+        }));
+        return made;
+    }();
+    return all;
+}
+
+
+/**
+ * Run a stage over a corpus for as many iterations as the benchmark needs,
+ * and report its throughput, time per run and allocations.
+ *
+ * @param state the Google Benchmark state
+ * @param corpus the corpus the stage is run over
+ * @param stage runs the stage once
+ */
+template <typename Stage>
+static void runStage(benchmark::State& state, const Corpus& corpus,
+        Stage stage) {
+    const std::size_t allocationsBefore = allocationCount.load();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(stage());
+        benchmark::ClobberMemory();
+    }
+    const std::size_t allocations = allocationCount.load()
+        - allocationsBefore;
+
+    const double iterations = static_cast<double>(state.iterations());
+    state.SetBytesProcessed(state.iterations() * corpus.text.size());
+    state.counters["time/run"] = benchmark::Counter(
+        iterations * corpus.runs,
+        benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.counters["allocs/MB"] = benchmark::Counter(
+        allocations / (iterations * corpus.text.size() / 1e6));
+}
+
+
+/**
+ * Register every stage for every corpus.
+ */
+static void registerBenchmarks() {
+    for (const Corpus& corpus : corpora()) {
+        const Corpus* c = &corpus;
+        auto add = [&](const std::string& stage, auto run) {
+            benchmark::RegisterBenchmark((stage + "/" + c->name).c_str(),
+                [c, run](benchmark::State& state) {
+                    runStage(state, *c, [c, &run] { return run(*c); });
+                })->Unit(benchmark::kMillisecond);
+        };
+
+        // The legacy token pipeline, one stage at a time
+        add("tokenizeUnencoded", [](const Corpus& c) {
+            return tokenizeUnencoded(c.text).size();
+        });
+        add("encodeTokens", [](const Corpus& c) {
+            return encodeTokens(c.dTokens).size();
+        });
+        add("concatenateEncoded", [](const Corpus& c) {
+            return vectorConcatenate(c.eTokens).size();
+        });
+        add("tokenizeEncoded", [](const Corpus& c) {
+            return tokenizeEncoded(c.encoded).size();
+        });
+        add("decodeTokens", [](const Corpus& c) {
+            return decodeTokens(c.readTokens).size();
+        });
+        add("concatenateDecoded", [](const Corpus& c) {
+            return vectorConcatenate(c.dTokens).size();
+        });
+
+        // Tokenizing into views of the input, and into an arena
+        add("tokenizeUnencodedViews", [](const Corpus& c) {
+            std::vector<std::string_view> tokens;
+            tokenizeUnencoded(c.text, tokens);
+            return tokens.size();
+        });
+        add("tokenizeUnencodedArena", [](const Corpus& c) {
+            std::pmr::monotonic_buffer_resource arena;
+            std::pmr::vector<std::pmr::string> tokens{ &arena };
+            tokenizeUnencoded(c.text, tokens);
+            return tokens.size();
+        });
+        add("tokenizeEncodedViews", [](const Corpus& c) {
+            std::vector<std::string_view> tokens;
+            tokenizeEncoded(c.encoded, tokens);
+            return tokens.size();
+        });
+
+        // The same pipeline, on Run tokens
+        add("tokenizeUnencodedRuns", [](const Corpus& c) {
+            std::vector<Run> runs;
+            tokenizeUnencoded(c.text, runs);
+            return runs.size();
+        });
+        add("encodeRuns", [](const Corpus& c) {
+            OutputBuffer out;
+            encodeTokens(c.runTokens, out);
+            return out.size();
+        });
+        add("tokenizeEncodedRuns", [](const Corpus& c) {
+            std::vector<Run> runs;
+            tokenizeEncoded(c.encoded, runs);
+            return runs.size();
+        });
+        add("decodeRuns", [](const Corpus& c) {
+            OutputBuffer out;
+            decodeTokens(c.runTokens, out);
+            return out.size();
+        });
+
+        // The single-pass codec, for comparison with the whole pipeline
+        add("encode", [](const Corpus& c) {
+            OutputBuffer out;
+            encode(c.text, out);
+            return out.size();
+        });
+        add("decode", [](const Corpus& c) {
+            OutputBuffer out;
+            decode(c.encoded, out);
+            return out.size();
+        });
+        add("batchDecode", [](const Corpus& c) {
+            OutputBuffer out{ c.text.size() };
+            out.commit(batchDecodeInto(c.encoded, out.prepare(c.text.size()),
+                c.text.size()));
+            return out.size();
+        });
+        add("validate", [](const Corpus& c) {
+            CodecError error;
+            return validateEncoded(c.encoded, error);
+        });
+
+        // Consuming the decoded text lazily, by run and by char
+        add("forEachRun", [](const Corpus& c) {
+            std::array<std::size_t, 256> histogram{};
+            forEachRun(c.encoded, [&](std::size_t count, char byte) {
+                histogram[static_cast<unsigned char>(byte)] += count;
+            });
+            return histogram['a'];
+        });
+        add("decodedView", [](const Corpus& c) {
+            DecodedView view{ c.encoded };
+            return std::count(view.begin(), view.end(), 'a');
+        });
+
+        // The hybrid literal/run format
+        add("encodeHybrid", [](const Corpus& c) {
+            OutputBuffer out;
+            encodeHybrid(c.text, out);
+            return out.size();
+        });
+        add("decodeHybrid", [](const Corpus& c) {
+            OutputBuffer out;
+            decodeHybrid(c.hybridEncoded, out);
+            return out.size();
+        });
+
+        // The codec specialized for text with no digits or '#' chars, which
+        // only applies to corpora without either
+        if (corpus.text.find_first_of("0123456789#") == std::string::npos) {
+            add("encodeLetters", [](const Corpus& c) {
+                OutputBuffer out;
+                BasicRLE<LettersPolicy>::encode(c.text, out);
+                return out.size();
+            });
+            add("decodeLetters", [](const Corpus& c) {
+                OutputBuffer out;
+                BasicRLE<LettersPolicy>::decode(c.encoded, out);
+                return out.size();
+            });
+        }
+    }
+}
+
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    registerBenchmarks();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -22,24 +22,28 @@
  *             This case is an issue, as the token must be separated from the
  *             next, lest the token be confused with the next one's char count
  * 
- * Invoke from the command line with your file path as the first argument.
- * File must have the extension ".txt" and use ASCII encoding.
- * 
  * Written by Jasper Law 2020
  * https://github.com/Trimatix/cpp-run-length-encoder
  */
 #include "jRLE.h"
+#include "jRLEIO.h"
+#include "jRLEScan.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
 
 
 /**
- * Read the contents of the requested text file, and return it as a string
+ * Ensure that the given path names a text file, with the extension '.txt'
  * 
  * @param fname path to the desired text file
- * @return std::string containing the contents of the file
- * @throw std::ios_base::failure if the file could not be opened
+ * @throw std::invalid_argument if the path does not end with '.txt'
  */
-std::string readFile(std::string fname) {
-    // Validate provided file extension
+void validateFilePath(const std::string& fname) {
     if (fname.length() < 4 ||
             fname.substr(fname.length() - 4, 4) != ".txt") {
 
@@ -48,26 +52,36 @@ std::string readFile(std::string fname) {
         throw std::invalid_argument("Invalid file path '" + fname
             + "' - path must end with the file extension '.txt'");
     }
+}
 
-    // Initialize file reader
-    std::ifstream freader{ fname };
 
-    // Handle invalid file paths
-    if (!freader) {
-        std::cerr << "Error opening file '" + fname
-            + "' - Ensure path is correct and file is not in use.\n";
-        throw std::ios_base::failure("Error opening file '" + fname
-            + "' - Ensure path is correct and file is not in use.");
-    }
-    
-    // Read file contents
+/**
+ * Read the contents of the requested text file, and return it as a string
+ * 
+ * @param fname path to the desired text file
+ * @return std::string containing the contents of the file
+ * @throw std::ios_base::failure if the file could not be opened
+ */
+std::string readFile(const std::string& fname) {
+    // Validate provided file extension
+    validateFilePath(fname);
+
+    // Map the file, rather than reading it line by line
     std::string fcontents;
-    std::string line;
-    while(std::getline(freader, line)){
-        fcontents += line + '\n';
+    try {
+        MappedInputFile freader{ fname };
+        // Leave space for a final '\n', so that adding it cannot reallocate
+        fcontents.reserve(freader.view().length() + 1);
+        fcontents.assign(freader.view());
+    } catch (const std::ios_base::failure& e) {
+        std::cerr << e.what() << '\n';
+        throw;
     }
 
-    freader.close();
+    // Every line read is terminated with '\n', including the last
+    if (!fcontents.empty() && fcontents.back() != '\n') {
+        fcontents += '\n';
+    }
     return fcontents;
 }
 
@@ -76,104 +90,74 @@ std::string readFile(std::string fname) {
  * Write the passed string to the requested text file
  * 
  * @param fname path to the desired text file
- * @return std::string containing the desired contents of the file
+ * @param inText the desired contents of the file
  * @throw std::ios_base::failure if the file could not be opened
  */
-void writeFile(std::string fname, std::string inText) {
+void writeFile(const std::string& fname, std::string_view inText) {
     // Validate provided file extension
-    if (fname.length() < 4 ||
-            fname.substr(fname.length() - 4, 4) != ".txt") {
-
-        std::cerr << "Invalid file path '" + fname
-            + "' - path must end with the file extension '.txt'";
-        throw std::invalid_argument("Invalid file path '" + fname
-            + "' - path must end with the file extension '.txt'");
+    validateFilePath(fname);
+
+    // Write the file contents straight into the mapped file
+    try {
+        MappedOutputFile fwriter{ fname, inText.length() };
+        fwriter.buffer().append(inText);
+        fwriter.commit();
+    } catch (const std::ios_base::failure& e) {
+        std::cerr << e.what() << '\n';
+        throw;
     }
-
-    // Initialize file reader
-    std::ofstream fwriter{ fname };
-
-    // Handle invalid file paths
-    if (!fwriter) {
-        std::cerr << "Error opening file '" + fname
-            + "' - Ensure path is correct and file is not in use.\n";
-        throw std::ios_base::failure("Error opening file '" + fname
-            + "' - Ensure path is correct and file is not in use.");
-    }
-    
-    // Write file contents
-    fwriter << inText;
-    fwriter.close();
 }
 
 
 /**
- * Split an unencoded string into a vector of unencoded tokens
+ * Find each unencoded token in a string, in order.
  * 
- * @param inText std::string containing the unencoded text to tokenize
- * @return std::vector of std::strings representing dTokens
+ * @param inText the unencoded text to tokenize
+ * @param emit called with a view of each dToken, as a substring of inText
  */
-std::vector<std::string> tokenizeUnencoded(std::string inText) {
-    // Special case: empty string
-    if (inText.empty()) {
-        return {};
-    }
-
-    // Starting index of the current token in the string
-    int currentSeqStart{0};
-    // The finished vector of unencoded tokens
-    std::vector<std::string> dTokens{};
-
-    // Loop over all characters in the string, start with the 1st
-    for (int i{0}; i < inText.length(); i++) {
-        // If the current char is different to the previous, or if X is the
-        // last char in the string.
-        if (i == inText.length() - 1 || inText.at(i) != inText.at(i+1)) {
-            // Add a new token containing the chars in inText, from
-            // currentSeqStart to the previous char
-            dTokens.push_back(inText.substr(currentSeqStart,
-                i - currentSeqStart + 1));
-            // Start a new sequence from the current char
-            currentSeqStart = i+1;
-        }
+template <typename Emit>
+static void findUnencodedTokens(std::string_view inText, Emit emit) {
+    const char* end = inText.data() + inText.length();
+
+    // Loop over all runs in the string, start with the 1st
+    for (const char* currentSeqStart = inText.data(); currentSeqStart < end;) {
+        // Find the first char that is different to the current run
+        const char* seqEnd = findRunEnd(currentSeqStart, end);
+        // Emit the chars in inText, from currentSeqStart to the end of the run
+        emit(std::string_view(currentSeqStart, seqEnd - currentSeqStart));
+        // Start a new sequence from the first different char
+        currentSeqStart = seqEnd;
     }
-
-    return dTokens;
 }
 
 
 /**
- * Split a run-length encoded string into a vector of encoded tokens
+ * Find each encoded token in a string, in order.
  * 
- * @param inText std::string containing the encoded text to tokenize
- * @return std::vector of std::strings representing eTokens
+ * @param inText the encoded text to tokenize
+ * @param emit called with a view of each eToken, as a substring of inText
  * @throw std::invalid_argument if a token is not accompanied by its char count
  */
-std::vector<std::string> tokenizeEncoded(std::string inText) {
-    // Special case: empty string
-    if (inText.empty()) {
-        return {};
-    }
-
-    // The finished vector of eTokens
-    std::vector<std::string> eTokens{};
+template <typename Emit>
+static void findEncodedTokens(std::string_view inText, Emit emit) {
     // The starting index of the current long sequence
-    // -1 indicates the current token is not a long sequence
-    int longSeqStart {-1};
+    // npos indicates the current token is not a long sequence
+    std::size_t longSeqStart {std::string_view::npos};
     // Temporary variable containing the token currently being read.
     // Not always used.
-    std::string newToken;
+    std::string_view newToken;
 
     // Iterate over all characters in inText
-    for (int i {0}; i < inText.length(); i++) {
+    for (std::size_t i {0}; i < inText.length(); i++) {
         // Temporary variable containing the currently read character
         char currentChar = inText.at(i);
         // If the current token is a long sequence
-        if (longSeqStart != -1) {
-            if (!isdigit(currentChar)) {
+        if (longSeqStart != std::string_view::npos) {
+            if (!isdigit(static_cast<unsigned char>(currentChar))) {
                 if (currentChar == '#') {
-                    // If the next character is #
-                    if (inText.at(i+1) == '#') {
+                    // If the next character is #. A # ending the text
+                    // has no next character.
+                    if (i + 1 < inText.length() && inText[i+1] == '#') {
                         // #-case b
                         // Add a new token with the chars in inText,
                         // from longSeqStart to char after the current
@@ -203,12 +187,13 @@ std::vector<std::string> tokenizeEncoded(std::string inText) {
                     newToken = inText.substr(longSeqStart,
                         i - longSeqStart + 1);
                     // No # detected, so disable long sequence tracker
-                    longSeqStart = -1;
+                    longSeqStart = std::string_view::npos;
                 }
-                // Unless current char is EOF with no char count,
-                // push the new token to the vector
-                if (newToken != "\n") {
-                    eTokens.push_back(newToken);
+                // Unless current char is EOF with no char count, or a #
+                // with no char count continuing the long sequence of a
+                // #-case b, push the new token to the vector
+                if (!newToken.empty() && newToken != "\n") {
+                    emit(newToken);
                 }
             }
         // If the current token is not a long sequence
@@ -216,7 +201,7 @@ std::vector<std::string> tokenizeEncoded(std::string inText) {
             // Start a new long sequence if one is marked
             if (currentChar == '#') {
                 longSeqStart = i + 1;
-            } else if (!isdigit(inText.at(i))) {
+            } else if (!isdigit(static_cast<unsigned char>(currentChar))) {
                 // If a char exists that is not accompanied by a char count
                 // (except LFCR on EOF), the encoding is invalid. Throw error.
                 if (inText.at(i) != '\n' && i < inText.length() - 1) {
@@ -227,26 +212,135 @@ std::vector<std::string> tokenizeEncoded(std::string inText) {
             // If current char is a digit, this is a single-char token.
             } else if (inText.substr(i, 2) != "\n") {
                 // Add a new token containing the count and the char.
-                eTokens.push_back(inText.substr(i, 2));
+                emit(inText.substr(i, 2));
                 // Skip the token-defining char.
                 i++;
             }
         }
     }
 
+    // A long sequence of digit chars that ends the text, as written by
+    // encodeTokens() for a run of digits. The last digit is the token char,
+    // all before it the count.
+    if (longSeqStart < inText.length()) {
+        if (inText.length() - longSeqStart == 1) {
+            throw std::invalid_argument(
+                "Invalid encoded sequence. Missing token char at position "
+                + std::to_string(inText.length()));
+        }
+        emit(inText.substr(longSeqStart));
+    }
+}
+
+
+/**
+ * Split an unencoded string into a vector of unencoded tokens
+ * 
+ * @param inText the unencoded text to tokenize
+ * @return std::vector of std::strings representing dTokens
+ */
+std::vector<std::string> tokenizeUnencoded(std::string_view inText) {
+    // The finished vector of unencoded tokens
+    std::vector<std::string> dTokens{};
+    findUnencodedTokens(inText, [&](std::string_view token) {
+        dTokens.emplace_back(token);
+    });
+    return dTokens;
+}
+
+
+/**
+ * Split a run-length encoded string into a vector of encoded tokens
+ * 
+ * @param inText the encoded text to tokenize
+ * @return std::vector of std::strings representing eTokens
+ * @throw std::invalid_argument if a token is not accompanied by its char count
+ */
+std::vector<std::string> tokenizeEncoded(std::string_view inText) {
+    // The finished vector of eTokens
+    std::vector<std::string> eTokens{};
+    findEncodedTokens(inText, [&](std::string_view token) {
+        eTokens.emplace_back(token);
+    });
     return eTokens;
 }
 
 
+/**
+ * Split an unencoded string into unencoded tokens, appending views of them
+ * to a vector. The views refer to inText, so no token is copied.
+ * 
+ * @param inText the unencoded text to tokenize. Must outlive the views.
+ * @param dTokens the vector to append the dTokens of inText to
+ */
+void tokenizeUnencoded(std::string_view inText,
+        std::vector<std::string_view>& dTokens) {
+    findUnencodedTokens(inText, [&](std::string_view token) {
+        dTokens.push_back(token);
+    });
+}
+
+
+/**
+ * Split a run-length encoded string into encoded tokens, appending views of
+ * them to a vector. The views refer to inText, so no token is copied.
+ * 
+ * @param inText the encoded text to tokenize. Must outlive the views.
+ * @param eTokens the vector to append the eTokens of inText to
+ * @throw std::invalid_argument if a token is not accompanied by its char count
+ */
+void tokenizeEncoded(std::string_view inText,
+        std::vector<std::string_view>& eTokens) {
+    findEncodedTokens(inText, [&](std::string_view token) {
+        eTokens.push_back(token);
+    });
+}
+
+
+/**
+ * Split an unencoded string into unencoded tokens, appending them to a
+ * vector. Each token's text is allocated from the vector's memory resource,
+ * so all tokens can be released at once, e.g. by a
+ * std::pmr::monotonic_buffer_resource.
+ * 
+ * @param inText the unencoded text to tokenize
+ * @param dTokens the vector to append the dTokens of inText to
+ */
+void tokenizeUnencoded(std::string_view inText,
+        std::pmr::vector<std::pmr::string>& dTokens) {
+    findUnencodedTokens(inText, [&](std::string_view token) {
+        dTokens.emplace_back(token);
+    });
+}
+
+
+/**
+ * Split a run-length encoded string into encoded tokens, appending them to a
+ * vector. Each token's text is allocated from the vector's memory resource,
+ * so all tokens can be released at once, e.g. by a
+ * std::pmr::monotonic_buffer_resource.
+ * 
+ * @param inText the encoded text to tokenize
+ * @param eTokens the vector to append the eTokens of inText to
+ * @throw std::invalid_argument if a token is not accompanied by its char count
+ */
+void tokenizeEncoded(std::string_view inText,
+        std::pmr::vector<std::pmr::string>& eTokens) {
+    findEncodedTokens(inText, [&](std::string_view token) {
+        eTokens.emplace_back(token);
+    });
+}
+
+
 /**
  *  Concatenate the items in a vector of strings into a single string.
  * 
- * @param inVect the std::vector of std::strings to concatenate
+ * @param inVect the std::strings to concatenate
  * @return All items of inVect, in order, in a single std::string
  */
-std::string vectorConcatenate(std::vector<std::string> inVect) {
+std::string vectorConcatenate(const std::vector<std::string>& inVect) {
     std::string outStr{};
-    for (std::string currentToken: inVect) {
+    for (const std::string& currentToken: inVect) {
         outStr += currentToken;
     }
     return outStr;
@@ -257,10 +351,11 @@ std::string vectorConcatenate(std::vector<std::string> inVect) {
  * Individually run-length encode each item in a vector of tokens
  * Each token must only contain one or more of a single character
  * 
- * @param dTokens vector of ASCII-encoded std::strings to run-length encode
+ * @param dTokens ASCII-encoded std::strings to run-length encode
  * @return vector of encoded std::strings
  */
-std::vector<std::string> encodeTokens(std::vector<std::string> dTokens) {
+std::vector<std::string> encodeTokens(
+        const std::vector<std::string>& dTokens) {
     // Special case: empty vector
     if (dTokens.empty()) {
         return {};
@@ -268,34 +363,87 @@ std::vector<std::string> encodeTokens(std::vector<std::string> dTokens) {
 
     // The finished vector of eTokens
     std::vector<std::string> eTokens{};
-    // Temporary variables for the current processing and read tokens
-    std::string newToken{};
-    std::string currentToken;
+    eTokens.reserve(dTokens.size());
+    // Temporary space for the current processing token
+    char newToken[maxETokenLength];
+    // Whether the previous token consisted of digits (#-case c)
+    bool prevTokenDigit{false};
 
     // Iterate over all tokens in dTokens
-    for (int i{0}; i < dTokens.size(); i++) {
-        currentToken = dTokens.at(i);
-        newToken = "";
-        // #-case a
-        if (currentToken.length() > 9 ||
-        // OR #-case c (or both)
-                (i > 0 && isdigit(dTokens.at(i-1).front()))) {
-            // Preceed the token with a # symbol
-            newToken = "#";
-        }
+    for (const std::string& currentToken: dTokens) {
+        // Encode the length of the token with one of its characters,
+        // applying any #-cases
+        std::size_t tokenLength = writeEToken(newToken, currentToken.front(),
+            currentToken.length(), prevTokenDigit);
+        eTokens.emplace_back(newToken, tokenLength);
+
+        prevTokenDigit = isdigit(
+            static_cast<unsigned char>(currentToken.front()));
+    }
 
-        // Add a new token by concatenating the length of the token with
-        // one of its characters
-        newToken += std::to_string(currentToken.length()) + currentToken.front();
-        // If the token consists of # characters, mark it with an extra #
-        if (currentToken.front() == '#') {
-            newToken += "#";
-        }
+    return eTokens;
+}
 
-        eTokens.push_back(newToken);
+
+/**
+ * Read the char count at the start of an eToken.
+ * 
+ * @param digits the char count, without the token-defining char
+ * @return the value of the char count
+ * @throw std::invalid_argument if digits does not start with a number
+ * @throw std::out_of_range if the char count is too large
+ */
+static std::size_t readCount(std::string_view digits) {
+    std::size_t count{0};
+    std::from_chars_result result = std::from_chars(digits.data(),
+        digits.data() + digits.size(), count);
+    if (result.ec == std::errc::invalid_argument) {
+        throw std::invalid_argument("Invalid char count '"
+            + std::string(digits) + "'");
+    } else if (result.ec == std::errc::result_out_of_range) {
+        throw std::out_of_range("Char count too large '"
+            + std::string(digits) + "'");
     }
+    return count;
+}
 
-    return eTokens;
+
+/**
+ * Read the char count and token-defining char of a single eToken, as
+ * produced by tokenizeEncoded()
+ * 
+ * @param token the eToken to read
+ * @param count set to the number of chars the token describes
+ * @param c set to the char the token describes
+ * @throw std::invalid_argument if the token has no char count
+ * @throw std::out_of_range if the char count is too large
+ */
+static void readEToken(std::string_view token, std::size_t& count,
+        char& c) {
+    // A token needs at least a char count and a token-defining char
+    if (token.length() < 2) {
+        throw std::invalid_argument("Invalid eToken '" + std::string(token)
+            + "'");
+    // If the token describes a single non-# character
+    } else if (token.length() == 2
+            && isdigit(static_cast<unsigned char>(token.front()))) {
+        // The front character is the count, converted to int
+        count = token.front() - '0';
+        c = token.back();
+    // #-case b
+    } else if (token.back() == '#') {
+        // Assume #-case a as well to be safe.
+        // The token-defining character is the third character from the back
+        // (the back 2 are #), and the count is all preceeding characters
+        count = readCount(token.substr(0, token.length() - 2));
+        c = '#';
+    // #-case a
+    } else {
+        // Same as above, but using the last character as
+        // the token-defining character, and all preceeding for the count.
+        count = readCount(token.substr(0, token.length() - 1));
+        c = token.back();
+    }
 }
 
 
@@ -303,41 +451,26 @@ std::vector<std::string> encodeTokens(std::vector<std::string> dTokens) {
  * Individually run-length decode each item in a vector of tokens
  * Each token must contain an encoding of one or more of a single character
  * 
- * @param eTokens vector of ASCII-encoded std::strings to run-length decode
+ * @param eTokens ASCII-encoded std::strings to run-length decode
  * @return vector of decoded std::strings
  */
-std::vector<std::string> decodeTokens(std::vector<std::string> eTokens) {
+std::vector<std::string> decodeTokens(
+        const std::vector<std::string>& eTokens) {
     // Special case: empty vector
     if (eTokens.empty()) {
         return {};
     }
     // The finished vector of decoded tokens
     std::vector<std::string> dTokens{};
-
-    // Iterate over all encoded tokens
-    for (int i {0}; i < eTokens.size(); i++) {
-        std::string currentToken = eTokens.at(i);
-        // If the token describes a single non-# character
-        if (currentToken.length() == 2){
-            // Add a new token by concatenating the back character x times,
-            // where x is the front character, converted to int
-            dTokens.push_back(std::string(currentToken.front() - '0',
-                currentToken.back()));
-        // #-case b
-        } else if (currentToken.back() == '#') {
-            // Assume #-case a as well to be safe.
-            // Add a new token by concatenating character x, y times,
-            // where x is the third character from the back (the back 2 are #)
-            // and y is all preceeding characters
-            dTokens.push_back(std::string(stoi(currentToken.substr(0,
-                currentToken.length() - 2)), '#'));
-        // #-case a
-        } else {
-            // Same as above, but using the last character as
-            // the token-defining character, and all preceeding for the count.
-            dTokens.push_back(std::string(stoi(currentToken.substr(0,
-                currentToken.length() - 1)), currentToken.back()));
-        }
+    dTokens.reserve(eTokens.size());
+    std::size_t count;
+    char c;
+
+    // Iterate over all encoded tokens, adding a new token by concatenating
+    // the token-defining character count times
+    for (const std::string& currentToken : eTokens) {
+        readEToken(currentToken, count, c);
+        dTokens.emplace_back(count, c);
     }
 
     return dTokens;
@@ -345,66 +478,302 @@ std::vector<std::string> decodeTokens(std::vector<std::string> eTokens) {
 
 
 /**
- * Run-length encode or decode the given text file, and write back the result.
+ * Concatenate the items in a vector of strings into a single string,
+ * reusing the storage of the first item.
  * 
- * @param argc The number of arguments passed in argv
- * @param argv A two-long array of strings, defining the arguments below:
- * argv[0] is the function to perform: -e for encode, -d for decode.
- * argv[1] is the path to the input file. File must have the extension .txt
- * @throw std::invalid_argument If argv is not length 2
- * @throw std::invalid_argument If argv[0] is neither -e nor -d.
+ * @param inVect the std::strings to concatenate, which are consumed
+ * @return All items of inVect, in order, in a single std::string
  */
-int main(int argc, char* argv[]) {
-    // Require both arguments
-    if (argc < 3) {
-        std::string errstring =
-            "Missing required argument. Correct command format: ";
-        errstring += "jRLE.exe <-e | -d> file-path";
-        std::cerr << errstring << std::endl;
-        throw std::invalid_argument(errstring);
+std::string vectorConcatenate(std::vector<std::string>&& inVect) {
+    if (inVect.empty()) {
+        return {};
     }
 
-    std::string fileName = std::string(argv[2]);
-    std::string func = std::string(argv[1]);
-    std::string fileText = readFile(fileName);
-    std::vector<std::string> inTokens;
-    std::vector<std::string> outTokens;
-    std::string outText;
-
-    // Handle decoding
-    if (func == "-d") {
-        inTokens = tokenizeEncoded(fileText);
-        outTokens = decodeTokens(inTokens);
-        
-    // Handle encoding
-    } else if (func == "-e") {
-        inTokens = tokenizeUnencoded(fileText);
-        outTokens = encodeTokens(inTokens);
-    
-    // Handle invalid function arguments
-    } else {
-        std::cerr << "Invalid argument '" + func
-            + "' - arg1 must be behaviour flag '-e' or '-d'\n";
-        throw std::invalid_argument("Invalid argument '" + func
-            + "' - arg1 must be behaviour flag '-e' or '-d'");
+    std::size_t length{0};
+    for (const std::string& currentToken : inVect) {
+        length += currentToken.length();
     }
+    std::string outStr = std::move(inVect.front());
+    outStr.reserve(length);
+    for (std::size_t i{1}; i < inVect.size(); i++) {
+        outStr += inVect[i];
+    }
+    inVect.clear();
+    return outStr;
+}
 
-    // Concatenate and write the resulting vector to file
-    outText = vectorConcatenate(outTokens);
-    writeFile(fileName, outText);
- 
-    // Report the compression ratio
-    float ratio;
-    if (func == "-e") {
-        ratio = static_cast<float>(fileText.length()) /
-                    static_cast<float>(outText.length());
-    } else {
-        ratio = static_cast<float>(outText.length()) /
-                    static_cast<float>(fileText.length());
+
+/**
+ * Concatenate the items in a vector of strings, writing the result to the
+ * end of an OutputBuffer.
+ * 
+ * @param inVect the std::strings to concatenate
+ * @param out the buffer to append all items of inVect to, in order
+ */
+void vectorConcatenate(const std::vector<std::string>& inVect,
+        OutputBuffer& out) {
+    for (const std::string& currentToken : inVect) {
+        out.append(currentToken);
     }
-    std::cout << "Original file length: " + std::to_string(fileText.length())
-        + "\nNew length: " + std::to_string(outText.length())
-        + "\nCompression ratio: " + std::to_string(ratio);
+}
+
+
+/**
+ * Run-length encode each token in a sequence, writing the concatenated
+ * result to the end of an OutputBuffer.
+ * 
+ * @param dTokens the dTokens to run-length encode
+ * @param out the buffer to append the encoded text to
+ */
+template <typename Tokens>
+static void encodeTokensInto(const Tokens& dTokens, OutputBuffer& out) {
+    // Whether the previous token consisted of digits (#-case c)
+    bool prevTokenDigit{false};
+
+    for (const auto& currentToken : dTokens) {
+        char* token = out.prepare(maxETokenLength);
+        out.commit(writeEToken(token, currentToken.front(),
+            currentToken.length(), prevTokenDigit));
+        prevTokenDigit = isdigit(
+            static_cast<unsigned char>(currentToken.front()));
+    }
+}
+
+
+/**
+ * Run-length decode each token in a sequence, writing the concatenated
+ * result to the end of an OutputBuffer.
+ * 
+ * @param eTokens the eTokens to run-length decode
+ * @param out the buffer to append the decoded text to
+ */
+template <typename Tokens>
+static void decodeTokensInto(const Tokens& eTokens, OutputBuffer& out) {
+    std::size_t count;
+    char c;
+
+    for (const auto& currentToken : eTokens) {
+        readEToken(currentToken, count, c);
+        std::memset(out.prepare(count), c, count);
+        out.commit(count);
+    }
+}
+
+
+/**
+ * Run-length encode each item in a vector of tokens, writing the
+ * concatenated result to the end of an OutputBuffer. Equivalent to
+ * vectorConcatenate(encodeTokens(dTokens)), without creating an eToken
+ * for each token.
+ * 
+ * @param dTokens ASCII-encoded std::strings to run-length encode. Each must
+ *                only contain one or more of a single character
+ * @param out the buffer to append the encoded text to
+ */
+void encodeTokens(const std::vector<std::string>& dTokens, OutputBuffer& out) {
+    encodeTokensInto(dTokens, out);
+}
+
+
+/**
+ * Run-length encode each item in a vector of token views, writing the
+ * concatenated result to the end of an OutputBuffer.
+ * 
+ * @param dTokens ASCII-encoded dTokens to run-length encode. Each must
+ *                only contain one or more of a single character
+ * @param out the buffer to append the encoded text to
+ */
+void encodeTokens(const std::vector<std::string_view>& dTokens,
+        OutputBuffer& out) {
+    encodeTokensInto(dTokens, out);
+}
+
+
+/**
+ * Run-length encode each item in a vector of arena-allocated tokens,
+ * writing the concatenated result to the end of an OutputBuffer.
+ * 
+ * @param dTokens ASCII-encoded dTokens to run-length encode. Each must
+ *                only contain one or more of a single character
+ * @param out the buffer to append the encoded text to
+ */
+void encodeTokens(const std::pmr::vector<std::pmr::string>& dTokens,
+        OutputBuffer& out) {
+    encodeTokensInto(dTokens, out);
+}
+
+
+/**
+ * Run-length decode each item in a vector of tokens, writing the
+ * concatenated result to the end of an OutputBuffer. Equivalent to
+ * vectorConcatenate(decodeTokens(eTokens)), without creating a dToken
+ * for each token.
+ * 
+ * @param eTokens ASCII-encoded std::strings to run-length decode. Each must
+ *                contain an encoding of one or more of a single character
+ * @param out the buffer to append the decoded text to
+ */
+void decodeTokens(const std::vector<std::string>& eTokens, OutputBuffer& out) {
+    decodeTokensInto(eTokens, out);
+}
+
+
+/**
+ * Run-length decode each item in a vector of token views, writing the
+ * concatenated result to the end of an OutputBuffer.
+ * 
+ * @param eTokens ASCII-encoded eTokens to run-length decode. Each must
+ *                contain an encoding of one or more of a single character
+ * @param out the buffer to append the decoded text to
+ */
+void decodeTokens(const std::vector<std::string_view>& eTokens,
+        OutputBuffer& out) {
+    decodeTokensInto(eTokens, out);
+}
+
 
-    return 0;
+/**
+ * Run-length decode each item in a vector of arena-allocated tokens,
+ * writing the concatenated result to the end of an OutputBuffer.
+ * 
+ * @param eTokens ASCII-encoded eTokens to run-length decode. Each must
+ *                contain an encoding of one or more of a single character
+ * @param out the buffer to append the decoded text to
+ */
+void decodeTokens(const std::pmr::vector<std::pmr::string>& eTokens,
+        OutputBuffer& out) {
+    decodeTokensInto(eTokens, out);
+}
+
+
+/**
+ * Append a run of any length to a vector, splitting it into as many Runs as
+ * are needed to hold its count.
+ * 
+ * @param runs the vector to append to
+ * @param byte the char the run consists of
+ * @param count the number of chars in the run
+ */
+static void appendRun(std::vector<Run>& runs, char byte, std::size_t count) {
+    constexpr std::size_t maxCount = UINT32_MAX;
+    while (count > maxCount) {
+        runs.push_back({ static_cast<std::uint32_t>(maxCount), byte });
+        count -= maxCount;
+    }
+    if (count != 0) {
+        runs.push_back({ static_cast<std::uint32_t>(count), byte });
+    }
+}
+
+
+/**
+ * Split an unencoded string into runs, appending them to a vector.
+ * Unlike dTokens, runs hold only their char and its count, so need no
+ * storage of their own.
+ * 
+ * @param inText the unencoded text to tokenize
+ * @param runs the vector to append the runs of inText to
+ */
+void tokenizeUnencoded(std::string_view inText, std::vector<Run>& runs) {
+    const char* end = inText.data() + inText.length();
+
+    for (const char* runStart = inText.data(); runStart < end;) {
+        const char* runEnd = findRunEnd(runStart, end);
+        appendRun(runs, *runStart, runEnd - runStart);
+        runStart = runEnd;
+    }
+}
+
+
+/**
+ * Read the runs described by a run-length encoded string, appending them to
+ * a vector. Runs of no chars, such as "0a", are skipped.
+ * 
+ * @param inText the encoded text to tokenize
+ * @param runs the vector to append the runs described by inText to
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+void tokenizeEncoded(std::string_view inText, std::vector<Run>& runs) {
+    EncodedRunReader reader{ inText };
+    std::size_t count;
+    char c;
+
+    while (reader.next(count, c)) {
+        appendRun(runs, c, count);
+    }
+}
+
+
+/**
+ * Calculate the exact length of a sequence of runs once encoded, without
+ * encoding it.
+ * 
+ * @param runs the runs to measure. Each must have a count of at least 1.
+ * @return the number of chars encodeTokens() would write for runs
+ */
+std::size_t encodedLength(const std::vector<Run>& runs) {
+    std::size_t length{0};
+    // Whether the previous run consisted of digits (#-case c)
+    bool prevRunDigit{false};
+    for (const Run& run : runs) {
+        length += eTokenLength(run.byte, run.count, prevRunDigit);
+        prevRunDigit = isdigit(static_cast<unsigned char>(run.byte));
+    }
+    return length;
+}
+
+
+/**
+ * Calculate the exact length of the text described by a sequence of runs.
+ * 
+ * @param runs the runs to measure
+ * @return the sum of the counts of runs
+ */
+std::size_t decodedLength(const std::vector<Run>& runs) {
+    std::size_t length{0};
+    for (const Run& run : runs) {
+        length += run.count;
+    }
+    return length;
+}
+
+
+/**
+ * Run-length encode a sequence of runs, writing the result to the end of an
+ * OutputBuffer. Consecutive runs need not be of different chars.
+ * 
+ * @param runs the runs to encode. Each must have a count of at least 1.
+ * @param out the buffer to append the encoded text to
+ */
+void encodeTokens(const std::vector<Run>& runs, OutputBuffer& out) {
+    // Whether the previous run consisted of digits (#-case c)
+    bool prevRunDigit{false};
+
+    for (const Run& run : runs) {
+        char* token = out.prepare(maxETokenLength);
+        out.commit(writeEToken(token, run.byte, run.count, prevRunDigit));
+        prevRunDigit = isdigit(static_cast<unsigned char>(run.byte));
+    }
+}
+
+
+/**
+ * Expand a sequence of runs into the text they describe, writing the result
+ * to the end of an OutputBuffer. Space for the whole result is made once.
+ * 
+ * @param runs the runs to decode
+ * @param out the buffer to append the decoded text to
+ */
+void decodeTokens(const std::vector<Run>& runs, OutputBuffer& out) {
+    const std::size_t length = decodedLength(runs);
+    if (length == 0) {
+        return;
+    }
+
+    char* dest = out.prepare(length);
+    for (const Run& run : runs) {
+        std::memset(dest, run.byte, run.count);
+        dest += run.count;
+    }
+    out.commit(length);
 }
@@ -13,6 +13,38 @@
  * However, the functions provided as part of this program have potential
  * use cases outside of run-length encoding, to this program's spec.
  * 
+ * To tokenize without allocating a string for each token, use the overloads
+ * that take a std::vector<Run> instead. Each Run is a char and its count:
+ * std::vector<Run> runs;
+ * tokenizeUnencoded("aaa", runs);
+ * OutputBuffer out;
+ * encodeTokens(runs, out);
+ * 
+ * To en/decode without allocating each token, use encode() and decode()
+ * from jRLECodec.h:
+ * OutputBuffer out;
+ * encode("aaa", out);
+ * 
+ * To en/decode binary data, or text with few runs, use encodeBinary() and
+ * decodeBinary() from jRLEBinary.h. The binary format is not text, but
+ * handles bytes of any value, with compact run lengths.
+ * 
+ * To en/decode a variant of the format, with a different marker, threshold
+ * or count radix, or text known to contain no digits or '#' chars, use
+ * BasicRLE from jRLEPolicy.h. Each variant is specialized at compile time.
+ * 
+ * To encode on multiple threads, use encodeParallel() from jRLEParallel.h.
+ * To decode on multiple threads, or decode only part of the text, use the
+ * seekable block container format from jRLEContainer.h.
+ * To decode only part of plain encoded text, index it with RunIndex from
+ * jRLEIndex.h.
+ * 
+ * To en/decode files without copying them into memory, map them with
+ * MappedInputFile and MappedOutputFile from jRLEIO.h.
+ * 
+ * To en/decode text too large to hold in memory, use the streaming
+ * StreamEncoder and StreamDecoder classes from jRLEStream.h instead.
+ * 
  * 
  *                   == Terminology ==
  * In this program, the term "token" refers to a description of
@@ -47,11 +79,41 @@
  * https://github.com/Trimatix/cpp-run-length-encoder
  */
 
+#ifndef JRLE_H
+#define JRLE_H
+
 #include <fstream>
 #include <iostream>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "jRLEAppend.h"
+#include "jRLEBatch.h"
+#include "jRLEBinary.h"
+#include "jRLECodec.h"
+#include "jRLEContainer.h"
+#include "jRLEContext.h"
+#include "jRLEHybrid.h"
+#include "jRLEIndex.h"
+#include "jRLEIO.h"
+#include "jRLEParallel.h"
+#include "jRLEPolicy.h"
+#include "jRLEQuery.h"
+#include "jRLEStats.h"
+#include "jRLEStream.h"
+#include "jRLEView.h"
+
+
+/**
+ * Ensure that the given path names a text file, with the extension '.txt'
+ * 
+ * @param fname path to the desired text file
+ * @throw std::invalid_argument if the path does not end with '.txt'
+ */
+void validateFilePath(const std::string& fname);
+
 
 /**
  * Read the contents of the requested text file, and return it as a string.
@@ -61,7 +123,7 @@
  * @return std::string containing the contents of the file
  * @throw std::ios_base::failure if the file could not be opened
  */
-std::string readFile(std::string fname);
+std::string readFile(const std::string& fname);
 
 
 /**
@@ -69,55 +131,265 @@ std::string readFile(std::string fname);
  * The file must have the extension '.txt'
  * 
  * @param fname path to the desired text file
- * @return std::string containing the desired contents of the file
+ * @param inText the desired contents of the file
  * @throw std::ios_base::failure if the file could not be opened
  */
-void writeFile(std::string fname, std::string inText);
+void writeFile(const std::string& fname, std::string_view inText);
 
 
 /**
  * Split an unencoded string into a vector of unencoded tokens
  * 
- * @param inText std::string containing the unencoded text to tokenize
+ * @param inText the unencoded text to tokenize
  * @return std::vector of std::strings representing dTokens
  */
-std::vector<std::string> tokenizeUnencoded(std::string inText);
+std::vector<std::string> tokenizeUnencoded(std::string_view inText);
 
 
 /**
  * Split a run-length encoded string into a vector of encoded tokens
  * 
- * @param inText std::string containing the encoded text to tokenize
+ * @param inText the encoded text to tokenize
  * @return std::vector of std::strings representing eTokens
  * @throw std::invalid_argument if a token is not accompanied by its char count
  */
-std::vector<std::string> tokenizeEncoded(std::string inText);
+std::vector<std::string> tokenizeEncoded(std::string_view inText);
 
 
 /**
  * Concatenate the items in a vector of strings into a single string.
  * 
- * @param inVect the std::vector of std::strings to concatenate
+ * @param inVect the std::strings to concatenate
  * @return All items of inVect, in order, in a single std::string
  */
-std::string vectorConcatenate(std::vector<std::string> inVect);
+std::string vectorConcatenate(const std::vector<std::string>& inVect);
 
 
 /**
  * Individually run-length encode each item in a vector of tokens
  * Each token must only contain one or more of a single character
  * 
- * @param dTokens vector of ASCII-encoded std::strings to run-length encode
+ * @param dTokens ASCII-encoded std::strings to run-length encode
  * @return vector of encoded std::strings
  */
-std::vector<std::string> encodeTokens(std::vector<std::string> dTokens);
+std::vector<std::string> encodeTokens(
+    const std::vector<std::string>& dTokens);
 
 
 /**
  * Individually run-length decode each item in a vector of tokens
  * Each token must contain an encoding of one or more of a single character
  * 
- * @param eTokens vector of ASCII-encoded std::strings to run-length decode
+ * @param eTokens ASCII-encoded std::strings to run-length decode
  * @return vector of decoded std::strings
  */
-std::vector<std::string> decodeTokens(std::vector<std::string> eTokens);
+std::vector<std::string> decodeTokens(
+    const std::vector<std::string>& eTokens);
+
+
+/**
+ * Concatenate the items in a vector of strings into a single string,
+ * reusing the storage of the first item.
+ * 
+ * @param inVect the std::strings to concatenate, which are consumed
+ * @return All items of inVect, in order, in a single std::string
+ */
+std::string vectorConcatenate(std::vector<std::string>&& inVect);
+
+
+/**
+ * Concatenate the items in a vector of strings, writing the result to the
+ * end of an OutputBuffer.
+ * 
+ * @param inVect the std::strings to concatenate
+ * @param out the buffer to append all items of inVect to, in order
+ */
+void vectorConcatenate(const std::vector<std::string>& inVect,
+    OutputBuffer& out);
+
+
+/**
+ * Run-length encode each item in a vector of tokens, writing the
+ * concatenated result to the end of an OutputBuffer. Equivalent to
+ * vectorConcatenate(encodeTokens(dTokens)), without creating an eToken
+ * for each token.
+ * 
+ * @param dTokens ASCII-encoded std::strings to run-length encode. Each must
+ *                only contain one or more of a single character
+ * @param out the buffer to append the encoded text to
+ */
+void encodeTokens(const std::vector<std::string>& dTokens, OutputBuffer& out);
+
+
+/**
+ * Run-length decode each item in a vector of tokens, writing the
+ * concatenated result to the end of an OutputBuffer. Equivalent to
+ * vectorConcatenate(decodeTokens(eTokens)), without creating a dToken
+ * for each token.
+ * 
+ * @param eTokens ASCII-encoded std::strings to run-length decode. Each must
+ *                contain an encoding of one or more of a single character
+ * @param out the buffer to append the decoded text to
+ */
+void decodeTokens(const std::vector<std::string>& eTokens, OutputBuffer& out);
+
+
+/**
+ * Split an unencoded string into unencoded tokens, appending views of them
+ * to a vector. The views refer to inText, so no token is copied.
+ * 
+ * @param inText the unencoded text to tokenize. Must outlive the views.
+ * @param dTokens the vector to append the dTokens of inText to
+ */
+void tokenizeUnencoded(std::string_view inText,
+    std::vector<std::string_view>& dTokens);
+
+
+/**
+ * Split a run-length encoded string into encoded tokens, appending views of
+ * them to a vector. The views refer to inText, so no token is copied.
+ * 
+ * @param inText the encoded text to tokenize. Must outlive the views.
+ * @param eTokens the vector to append the eTokens of inText to
+ * @throw std::invalid_argument if a token is not accompanied by its char count
+ */
+void tokenizeEncoded(std::string_view inText,
+    std::vector<std::string_view>& eTokens);
+
+
+/**
+ * Run-length encode each item in a vector of token views, writing the
+ * concatenated result to the end of an OutputBuffer.
+ * 
+ * @param dTokens ASCII-encoded dTokens to run-length encode. Each must
+ *                only contain one or more of a single character
+ * @param out the buffer to append the encoded text to
+ */
+void encodeTokens(const std::vector<std::string_view>& dTokens,
+    OutputBuffer& out);
+
+
+/**
+ * Run-length decode each item in a vector of token views, writing the
+ * concatenated result to the end of an OutputBuffer.
+ * 
+ * @param eTokens ASCII-encoded eTokens to run-length decode. Each must
+ *                contain an encoding of one or more of a single character
+ * @param out the buffer to append the decoded text to
+ */
+void decodeTokens(const std::vector<std::string_view>& eTokens,
+    OutputBuffer& out);
+
+
+/**
+ * Split an unencoded string into unencoded tokens, appending them to a
+ * vector. Each token's text is allocated from the vector's memory resource,
+ * so all tokens can be released at once, e.g. by a
+ * std::pmr::monotonic_buffer_resource.
+ * 
+ * @param inText the unencoded text to tokenize
+ * @param dTokens the vector to append the dTokens of inText to
+ */
+void tokenizeUnencoded(std::string_view inText,
+    std::pmr::vector<std::pmr::string>& dTokens);
+
+
+/**
+ * Split a run-length encoded string into encoded tokens, appending them to a
+ * vector. Each token's text is allocated from the vector's memory resource,
+ * so all tokens can be released at once, e.g. by a
+ * std::pmr::monotonic_buffer_resource.
+ * 
+ * @param inText the encoded text to tokenize
+ * @param eTokens the vector to append the eTokens of inText to
+ * @throw std::invalid_argument if a token is not accompanied by its char count
+ */
+void tokenizeEncoded(std::string_view inText,
+    std::pmr::vector<std::pmr::string>& eTokens);
+
+
+/**
+ * Run-length encode each item in a vector of arena-allocated tokens,
+ * writing the concatenated result to the end of an OutputBuffer.
+ * 
+ * @param dTokens ASCII-encoded dTokens to run-length encode. Each must
+ *                only contain one or more of a single character
+ * @param out the buffer to append the encoded text to
+ */
+void encodeTokens(const std::pmr::vector<std::pmr::string>& dTokens,
+    OutputBuffer& out);
+
+
+/**
+ * Run-length decode each item in a vector of arena-allocated tokens,
+ * writing the concatenated result to the end of an OutputBuffer.
+ * 
+ * @param eTokens ASCII-encoded eTokens to run-length decode. Each must
+ *                contain an encoding of one or more of a single character
+ * @param out the buffer to append the decoded text to
+ */
+void decodeTokens(const std::pmr::vector<std::pmr::string>& eTokens,
+    OutputBuffer& out);
+
+
+/**
+ * Split an unencoded string into runs, appending them to a vector.
+ * Unlike dTokens, runs hold only their char and its count, so need no
+ * storage of their own.
+ * 
+ * @param inText the unencoded text to tokenize
+ * @param runs the vector to append the runs of inText to
+ */
+void tokenizeUnencoded(std::string_view inText, std::vector<Run>& runs);
+
+
+/**
+ * Read the runs described by a run-length encoded string, appending them to
+ * a vector. Runs of no chars, such as "0a", are skipped.
+ * 
+ * @param inText the encoded text to tokenize
+ * @param runs the vector to append the runs described by inText to
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+void tokenizeEncoded(std::string_view inText, std::vector<Run>& runs);
+
+
+/**
+ * Calculate the exact length of a sequence of runs once encoded, without
+ * encoding it.
+ * 
+ * @param runs the runs to measure. Each must have a count of at least 1.
+ * @return the number of chars encodeTokens() would write for runs
+ */
+std::size_t encodedLength(const std::vector<Run>& runs);
+
+
+/**
+ * Calculate the exact length of the text described by a sequence of runs.
+ * 
+ * @param runs the runs to measure
+ * @return the sum of the counts of runs
+ */
+std::size_t decodedLength(const std::vector<Run>& runs);
+
+
+/**
+ * Run-length encode a sequence of runs, writing the result to the end of an
+ * OutputBuffer. Consecutive runs need not be of different chars.
+ * 
+ * @param runs the runs to encode. Each must have a count of at least 1.
+ * @param out the buffer to append the encoded text to
+ */
+void encodeTokens(const std::vector<Run>& runs, OutputBuffer& out);
+
+
+/**
+ * Expand a sequence of runs into the text they describe, writing the result
+ * to the end of an OutputBuffer. Space for the whole result is made once.
+ * 
+ * @param runs the runs to decode
+ * @param out the buffer to append the decoded text to
+ */
+void decodeTokens(const std::vector<Run>& runs, OutputBuffer& out);
+
+#endif
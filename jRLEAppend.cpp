@@ -0,0 +1,234 @@
+/**
+ * Incremental encoding of growing text for jRLE.
+ * See jRLEAppend.h for usage, and for the sidecar layout.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLEAppend.h"
+#include "jRLEPolicy.h"
+#include "jRLEScan.h"
+
+#include <cstdint>
+#include <cstring>
+
+
+constexpr char appendStateMagic[4] = { 'J', 'R', 'L', 'A' };
+constexpr std::uint8_t appendStateVersion = 1;
+
+
+/**
+ * Write a u64 in little-endian byte order.
+ *
+ * @param out pointer to space for 8 bytes
+ * @param value the value to write
+ */
+static void putU64(char* out, std::uint64_t value) {
+    for (std::size_t i{0}; i < 8; i++) {
+        out[i] = static_cast<char>(value >> (8 * i));
+    }
+}
+
+
+/**
+ * Read a u64 in little-endian byte order.
+ *
+ * @param in pointer to 8 bytes
+ * @return the value read
+ */
+static std::uint64_t getU64(const char* in) {
+    std::uint64_t value{0};
+    for (std::size_t i{0}; i < 8; i++) {
+        value |= static_cast<std::uint64_t>(
+            static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+
+/**
+ * Find where the eToken just read ends. An eToken ending in #-case a or c
+ * with a marker shares the marker with the next eToken, as the start of its
+ * long sequence, so ends before it. A single-char eToken of a marker is
+ * read without the marker escaping it (#-case b), so ends after it.
+ *
+ * @param encoded the encoded text
+ * @param pos the position of the reader after reading the eToken
+ * @param longSeq whether that position lies within a long sequence
+ * @param c the char of the run read
+ * @return the position in encoded of the end of the eToken
+ */
+std::size_t eTokenEnd(std::string_view encoded, std::size_t pos, bool longSeq,
+        char c) {
+    if (longSeq && c != DefaultRLEPolicy::marker && pos != 0
+            && encoded[pos - 1] == DefaultRLEPolicy::marker) {
+        return pos - 1;
+    } else if (!longSeq && c == DefaultRLEPolicy::marker
+            && pos < encoded.size()
+            && encoded[pos] == DefaultRLEPolicy::marker) {
+        return pos + 1;
+    }
+    return pos;
+}
+
+
+/**
+ * Find the state of the end of plain encoded text, by reading all of it.
+ *
+ * @param encoded the encoded text
+ * @return the state of the end of encoded
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+AppendState scanAppendState(std::string_view encoded) {
+    AppendState state;
+    EncodedRunReader reader{ encoded };
+    std::size_t count;
+    char c;
+
+    while (reader.next(count, c)) {
+        state.prevRunDigit = state.encodedLength != 0
+            && DefaultRLE::isCountDigit(state.lastChar);
+        state.lastTokenOffset = state.encodedLength;
+        state.lastChar = c;
+        state.lastCount = count;
+        state.encodedLength = eTokenEnd(encoded, reader.position(),
+            reader.inLongSeq(), c);
+    }
+
+    return state;
+}
+
+
+/**
+ * Check that an AppendState describes the end of plain encoded text, by
+ * reading only its last eToken.
+ *
+ * @param encoded the encoded text
+ * @param state the state to check
+ * @return true if encoded ends with the last eToken described by state
+ */
+bool matchesAppendState(std::string_view encoded, const AppendState& state) {
+    if (state.encodedLength != encoded.size()) {
+        return false;
+    } else if (state.encodedLength == 0) {
+        return true;
+    } else if (state.lastTokenOffset >= state.encodedLength) {
+        return false;
+    }
+
+    std::size_t pos = state.lastTokenOffset;
+    bool longSeq{false};
+    std::size_t count;
+    char c;
+    CodecError error;
+    return DefaultRLE::readRun(encoded, pos, longSeq, count, c, error)
+        && c == state.lastChar && count == state.lastCount
+        && eTokenEnd(encoded, pos, longSeq, c) == state.encodedLength;
+}
+
+
+/**
+ * Run-length encode text to append to plain encoded text. If the text
+ * continues the last run of the encoded text, the last eToken is rewritten
+ * with the combined count. Writing the result at the returned offset, and
+ * discarding everything after it, gives the encoding of the combined text.
+ *
+ * @param in the unencoded text to append
+ * @param state the state of the end of the encoded text, updated to the
+ *              state once the result has been written
+ * @param out the buffer to append the encoded text to write to
+ * @return the position in the encoded text to write the result at
+ */
+std::size_t encodeAppend(std::string_view in, AppendState& state,
+        OutputBuffer& out) {
+    const bool hasLast = state.encodedLength != 0;
+    if (in.empty()) {
+        return state.encodedLength;
+    }
+
+    const std::size_t start = out.size();
+    std::size_t offset = state.encodedLength;
+    // Whether the run before the next one written consisted of digits
+    bool prevRunDigit = hasLast && DefaultRLE::isCountDigit(state.lastChar);
+    const char* pos = in.data();
+    const char* end = pos + in.size();
+
+    // Rewrite the last eToken, if the text continues its run
+    if (hasLast && *pos == state.lastChar) {
+        const char* runEnd = findRunEnd(pos, end);
+        offset = state.lastTokenOffset;
+        state.lastCount += runEnd - pos;
+        out.commit(writeEToken(out.prepare(maxETokenLength), state.lastChar,
+            state.lastCount, state.prevRunDigit));
+        pos = runEnd;
+        if (pos == end) {
+            state.encodedLength = offset + (out.size() - start);
+            return offset;
+        }
+    }
+
+    // Encode all but the last run, then keep where its eToken is written
+    const char* lastRun = end - 1;
+    while (lastRun != pos && lastRun[-1] == *lastRun) {
+        lastRun--;
+    }
+    encode({ pos, static_cast<std::size_t>(lastRun - pos) }, out,
+        prevRunDigit);
+    if (lastRun != pos) {
+        prevRunDigit = DefaultRLE::isCountDigit(lastRun[-1]);
+    }
+    state.lastTokenOffset = offset + (out.size() - start);
+    state.lastChar = *lastRun;
+    state.lastCount = end - lastRun;
+    state.prevRunDigit = prevRunDigit;
+    out.commit(writeEToken(out.prepare(maxETokenLength), state.lastChar,
+        state.lastCount, prevRunDigit));
+    state.encodedLength = offset + (out.size() - start);
+
+    return offset;
+}
+
+
+/**
+ * Write an AppendState in the sidecar layout.
+ *
+ * @param state the state to write
+ * @return appendStateLength bytes describing state
+ */
+std::string serializeAppendState(const AppendState& state) {
+    std::string data(appendStateLength, '\0');
+    std::memcpy(&data[0], appendStateMagic, sizeof(appendStateMagic));
+    data[4] = static_cast<char>(appendStateVersion);
+    putU64(&data[5], state.encodedLength);
+    putU64(&data[13], state.lastTokenOffset);
+    putU64(&data[21], state.lastCount);
+    data[29] = state.lastChar;
+    data[30] = static_cast<char>(state.prevRunDigit);
+    return data;
+}
+
+
+/**
+ * Read an AppendState written by serializeAppendState().
+ *
+ * @param data the bytes to read
+ * @param state set to the state read, if data is valid
+ * @return true if data is a valid serialized AppendState
+ */
+bool parseAppendState(std::string_view data, AppendState& state) {
+    if (data.size() != appendStateLength
+            || std::memcmp(data.data(), appendStateMagic,
+                sizeof(appendStateMagic)) != 0
+            || static_cast<std::uint8_t>(data[4]) != appendStateVersion
+            || static_cast<std::uint8_t>(data[30]) > 1) {
+        return false;
+    }
+    AppendState read;
+    read.encodedLength = getU64(&data[5]);
+    read.lastTokenOffset = getU64(&data[13]);
+    read.lastCount = getU64(&data[21]);
+    read.lastChar = data[29];
+    read.prevRunDigit = data[30] == 1;
+    state = read;
+    return true;
+}
@@ -0,0 +1,153 @@
+/**
+ * Incremental encoding of growing text for jRLE, such as append-only logs.
+ *
+ * Encoding text split anywhere but at the end of a run cannot simply be
+ * concatenated: the run at the end of the old text continues into the new
+ * text, and an eToken following a run of digits needs a '#' (#-case c).
+ * An AppendState records just enough about the end of plain encoded text
+ * to append more text to it exactly: where its last eToken starts and
+ * ends, the run that eToken describes, and whether the run before it
+ * consisted of digits. Appending then costs time in the length of the new
+ * text only, rewriting at most the last eToken of the old text.
+ *
+ * The state is small, and can be kept between appends in a sidecar file
+ * alongside the encoded text, with serializeAppendState() and
+ * parseAppendState(). If the sidecar is missing or does not match the
+ * encoded text, scanAppendState() rebuilds it from the encoded text once.
+ *
+ *              == Sidecar Layout ==
+ * All integers are unsigned and little-endian.
+ * - "JRLA" magic, and a 1-byte format version (currently 1)
+ * - u64 encoded length, to the end of the last eToken
+ * - u64 offset of the last eToken
+ * - u64 char count of the last run
+ * - The char of the last run
+ * - 1 byte: 1 if the run before the last consisted of digits, otherwise 0
+ *
+ * For example, to append text to encoded text held in a string:
+ * AppendState state = scanAppendState(encoded);
+ * OutputBuffer tail;
+ * std::size_t offset = encodeAppend(text, state, tail);
+ * encoded.replace(offset, std::string::npos, tail.view());
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_APPEND_H
+#define JRLE_APPEND_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "jRLECodec.h"
+
+
+/**
+ * The length in bytes of a serialized AppendState
+ */
+constexpr std::size_t appendStateLength = 31;
+
+
+/**
+ * The end of plain encoded text, as needed to append more text to it
+ */
+struct AppendState {
+    // The length of the encoded text, to the end of its last eToken
+    std::size_t encodedLength{0};
+    // The position in the encoded text of its last eToken
+    std::size_t lastTokenOffset{0};
+    // The run described by the last eToken. Meaningless if encodedLength
+    // is 0, as the text then has no eTokens.
+    char lastChar{0};
+    std::size_t lastCount{0};
+    // Whether the run before the last consisted of digits (#-case c)
+    bool prevRunDigit{false};
+};
+
+
+/**
+ * An upper bound on the length of the encoded text encodeAppend() writes.
+ *
+ * @param length the number of chars of unencoded text to append
+ * @return the capacity an OutputBuffer needs for encodeAppend()
+ */
+constexpr std::size_t appendLengthBound(std::size_t length) {
+    // The rewritten last eToken, and the encoded new text
+    return maxETokenLength + encodedLengthBound(length);
+}
+
+
+/**
+ * Find where the eToken just read ends. An eToken ending in #-case a or c
+ * with a marker shares the marker with the next eToken, as the start of its
+ * long sequence, so ends before it. A single-char eToken of a marker is
+ * read without the marker escaping it (#-case b), so ends after it.
+ *
+ * @param encoded the encoded text
+ * @param pos the position of the reader after reading the eToken
+ * @param longSeq whether that position lies within a long sequence
+ * @param c the char of the run read
+ * @return the position in encoded of the end of the eToken
+ */
+std::size_t eTokenEnd(std::string_view encoded, std::size_t pos, bool longSeq,
+    char c);
+
+
+/**
+ * Find the state of the end of plain encoded text, by reading all of it.
+ *
+ * @param encoded the encoded text
+ * @return the state of the end of encoded
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+AppendState scanAppendState(std::string_view encoded);
+
+
+/**
+ * Check that an AppendState describes the end of plain encoded text, by
+ * reading only its last eToken.
+ *
+ * @param encoded the encoded text
+ * @param state the state to check
+ * @return true if encoded ends with the last eToken described by state
+ */
+bool matchesAppendState(std::string_view encoded, const AppendState& state);
+
+
+/**
+ * Run-length encode text to append to plain encoded text. If the text
+ * continues the last run of the encoded text, the last eToken is rewritten
+ * with the combined count. Writing the result at the returned offset, and
+ * discarding everything after it, gives the encoding of the combined text.
+ *
+ * @param in the unencoded text to append
+ * @param state the state of the end of the encoded text, updated to the
+ *              state once the result has been written
+ * @param out the buffer to append the encoded text to write to
+ * @return the position in the encoded text to write the result at
+ */
+std::size_t encodeAppend(std::string_view in, AppendState& state,
+    OutputBuffer& out);
+
+
+/**
+ * Write an AppendState in the sidecar layout.
+ *
+ * @param state the state to write
+ * @return appendStateLength bytes describing state
+ */
+std::string serializeAppendState(const AppendState& state);
+
+
+/**
+ * Read an AppendState written by serializeAppendState().
+ *
+ * @param data the bytes to read
+ * @param state set to the state read, if data is valid
+ * @return true if data is a valid serialized AppendState
+ */
+bool parseAppendState(std::string_view data, AppendState& state);
+
+#endif
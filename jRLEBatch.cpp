@@ -0,0 +1,368 @@
+/**
+ * Batch decoding of plain run-length encoded blocks for jRLE.
+ * See jRLEBatch.h for usage.
+ *
+ * Runs are read into a RunTable, then written out by a fill kernel. Every
+ * kernel writes the runs of a table in order, so a store that writes past
+ * the end of its run is always overwritten by the runs after it.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLEBatch.h"
+#include "jRLEPolicy.h"
+#include "jRLEThreads.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+// The vectorized kernels are only built for x86
+#if defined(__SSE2__) || defined(_M_X64) \
+        || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JRLE_BATCH_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only allow AVX2 and AVX-512 intrinsics in functions marked
+// for them. MSVC allows them anywhere.
+#if defined(JRLE_BATCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define JRLE_TARGET_AVX2 __attribute__((target("avx2")))
+#define JRLE_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#else
+#define JRLE_TARGET_AVX2
+#define JRLE_TARGET_AVX512
+#endif
+
+
+/**
+ * The number of runs read into a RunTable before it is filled
+ */
+constexpr std::size_t runTableLength = 4096;
+
+
+/**
+ * Runs read from encoded text, waiting to be written to the output
+ */
+struct RunTable {
+    // The position in the output of each run, and of the end of the last:
+    // the prefix sum of the run counts
+    std::size_t starts[runTableLength + 1];
+    // The char of each run
+    char chars[runTableLength];
+};
+
+
+/**
+ * Portable fill kernel, writing each run with memset().
+ *
+ * @param out pointer to the output that the run positions are relative to
+ * @param table the runs to write
+ * @param runs the number of runs in the table
+ */
+static void fillRunsScalar(char* out, const RunTable& table,
+        std::size_t runs) {
+    for (std::size_t i{0}; i < runs; i++) {
+        std::memset(out + table.starts[i], table.chars[i],
+            table.starts[i + 1] - table.starts[i]);
+    }
+}
+
+
+#if defined(JRLE_BATCH_X86)
+/**
+ * AVX2 fill kernel, writing each run of up to 32 chars with one 32-byte
+ * store. A store is only made where at least 32 chars of the table's
+ * output remain, so its excess always lands on later runs.
+ */
+JRLE_TARGET_AVX2
+static void fillRunsAVX2(char* out, const RunTable& table,
+        std::size_t runs) {
+    const std::size_t end = table.starts[runs];
+    for (std::size_t i{0}; i < runs; i++) {
+        const std::size_t start = table.starts[i];
+        const std::size_t count = table.starts[i + 1] - start;
+        if (count <= 32 && end - start >= 32) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + start),
+                _mm256_set1_epi8(table.chars[i]));
+        } else {
+            std::memset(out + start, table.chars[i], count);
+        }
+    }
+}
+
+
+/**
+ * AVX-512 fill kernel, writing each run of up to 64 chars with one 64-byte
+ * store. Like the AVX2 kernel, a plain store is made where at least 64
+ * chars of the table's output remain. The last runs of the table are
+ * written with masked stores, which write exactly the chars of the run.
+ */
+JRLE_TARGET_AVX512
+static void fillRunsAVX512(char* out, const RunTable& table,
+        std::size_t runs) {
+    const std::size_t end = table.starts[runs];
+    for (std::size_t i{0}; i < runs; i++) {
+        const std::size_t start = table.starts[i];
+        const std::size_t count = table.starts[i + 1] - start;
+        if (count <= 64 && end - start >= 64) {
+            _mm512_storeu_si512(out + start,
+                _mm512_set1_epi8(table.chars[i]));
+        } else if (count < 64) {
+            const __mmask64 mask = (std::uint64_t{1} << count) - 1;
+            _mm512_mask_storeu_epi8(out + start, mask,
+                _mm512_set1_epi8(table.chars[i]));
+        } else {
+            std::memset(out + start, table.chars[i], count);
+        }
+    }
+}
+
+
+/**
+ * @return whether the CPU and operating system support AVX2
+ */
+static bool cpuHasAVX2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    // The OS must save the AVX registers (OSXSAVE and XCR0 bits 1 and 2)
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+
+/**
+ * @return whether the CPU and operating system support AVX-512F and
+ *         AVX-512BW
+ */
+static bool cpuHasAVX512() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    // The OS must also save the opmask and upper ZMM registers (XCR0 bits
+    // 5 to 7)
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0xE6) != 0xE6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0;
+#else
+    return __builtin_cpu_supports("avx512f")
+        && __builtin_cpu_supports("avx512bw");
+#endif
+}
+#endif
+
+
+// A fill kernel, and the name to report it by
+struct FillKernel {
+    void (*fill)(char*, const RunTable&, std::size_t);
+    const char* name;
+};
+
+
+/**
+ * Choose the fastest fill kernel supported by this CPU.
+ * The choice is made once, on first use.
+ */
+static const FillKernel& fillKernel() {
+    static const FillKernel kernel = []() -> FillKernel {
+#if defined(JRLE_BATCH_X86)
+        if (cpuHasAVX512()) {
+            return { fillRunsAVX512, "avx512" };
+        } else if (cpuHasAVX2()) {
+            return { fillRunsAVX2, "avx2" };
+        }
+#endif
+        return { fillRunsScalar, "scalar" };
+    }();
+    return kernel;
+}
+
+
+/**
+ * Run-length decode a string into a caller-supplied span of chars, with the
+ * batch decoder, reporting an error instead of throwing it. Equivalent to
+ * decodeInto(), with identical errors.
+ *
+ * @param in the encoded text to decode
+ * @param out pointer to space for the decoded text
+ * @param capacity the number of chars available at out. No more than the
+ *                 decoded text is ever written to it.
+ * @param error set to an invalidEncoding error if the encoded text is
+ *              invalid, or an outputTooSmall error if it decodes to more
+ *              than capacity chars. Left unchanged otherwise.
+ * @return the number of chars written to out: every run decoded before any
+ *         error
+ */
+std::size_t batchDecodeInto(std::string_view in, char* out,
+        std::size_t capacity, CodecError& error) {
+    const FillKernel& kernel = fillKernel();
+    RunTable table;
+    std::size_t pos{0};
+    bool longSeq{false};
+    std::size_t written{0};
+    bool more{true};
+    std::size_t count;
+    char c;
+
+    while (more) {
+        // Read a table of runs, then fill them all at once
+        std::size_t runs{0};
+        std::size_t end = written;
+        while (runs < runTableLength) {
+            if (!DefaultRLE::readRun(in, pos, longSeq, count, c, error)) {
+                more = false;
+                break;
+            }
+            if (count > capacity - end) {
+                error = { CodecStatus::outputTooSmall,
+                    "Decoded text too long", pos };
+                more = false;
+                break;
+            }
+            table.starts[runs] = end;
+            table.chars[runs] = c;
+            runs++;
+            end += count;
+        }
+        table.starts[runs] = end;
+        kernel.fill(out, table, runs);
+        written = end;
+    }
+
+    return written;
+}
+
+
+/**
+ * Run-length decode a string into a caller-supplied span of chars, with the
+ * batch decoder. Equivalent to decodeInto(), with identical errors.
+ *
+ * @param in the encoded text to decode
+ * @param out pointer to space for the decoded text
+ * @param capacity the number of chars available at out. No more than the
+ *                 decoded text is ever written to it.
+ * @return the number of chars written to out
+ * @throw std::invalid_argument if the encoded text is invalid, or decodes
+ *        to more than capacity chars
+ */
+std::size_t batchDecodeInto(std::string_view in, char* out,
+        std::size_t capacity) {
+    CodecError error;
+    const std::size_t written = batchDecodeInto(in, out, capacity, error);
+    if (error.status != CodecStatus::ok) {
+        invalidEncoding(error.reason, error.position);
+    }
+    return written;
+}
+
+
+/**
+ * Throw an exception describing an invalid block given to decodeBatch().
+ *
+ * @param block the index of the invalid block
+ * @param error description of the error in the block
+ * @throw std::invalid_argument always
+ */
+[[noreturn]] static void invalidBlock(std::size_t block,
+        const CodecError& error) {
+    throw std::invalid_argument("Invalid encoded sequence in block "
+        + std::to_string(block) + ". " + std::string(error.reason)
+        + " at position " + std::to_string(error.position));
+}
+
+
+/**
+ * Run-length decode many plain encoded blocks, writing their decoded texts
+ * one after another to the end of an OutputBuffer. Blocks are measured and
+ * decoded on multiple threads, each directly into its place in the output.
+ *
+ * @param blocks the encoded text of each block, in order
+ * @param out the buffer to append the decoded text to. If a block is
+ *            invalid, the buffer is left unchanged.
+ * @param threads the maximum number of threads to use.
+ *                0 uses one thread per hardware thread.
+ * @throw std::invalid_argument if a block is invalid, or the total decoded
+ *        length is too large
+ */
+void decodeBatch(const std::vector<std::string_view>& blocks,
+        OutputBuffer& out, unsigned threads) {
+    if (blocks.empty()) {
+        return;
+    }
+    const std::size_t numThreads = std::min<std::size_t>(
+        resolveThreadCount(threads), blocks.size());
+
+    // Measure every block, then place each after those before it
+    std::vector<std::size_t> offsets(blocks.size() + 1, 0);
+    std::atomic<std::size_t> nextBlock{0};
+    runOnThreads(numThreads, [&](std::size_t) {
+        std::size_t i;
+        while ((i = nextBlock++) < blocks.size()) {
+            CodecError error;
+            offsets[i + 1] = decodedLength(blocks[i], error);
+            if (error.status != CodecStatus::ok) {
+                invalidBlock(i, error);
+            }
+        }
+    });
+    for (std::size_t i{0}; i < blocks.size(); i++) {
+        if (offsets[i + 1] > std::numeric_limits<std::size_t>::max()
+                - offsets[i]) {
+            throw std::invalid_argument("Decoded length too large");
+        }
+        offsets[i + 1] += offsets[i];
+    }
+    const std::size_t total = offsets.back();
+    if (total == 0) {
+        return;
+    }
+
+    char* dest = out.prepare(total);
+    nextBlock = 0;
+    runOnThreads(numThreads, [&](std::size_t) {
+        std::size_t i;
+        while ((i = nextBlock++) < blocks.size()) {
+            CodecError error;
+            batchDecodeInto(blocks[i], dest + offsets[i],
+                offsets[i + 1] - offsets[i], error);
+            if (error.status != CodecStatus::ok) {
+                invalidBlock(i, error);
+            }
+        }
+    });
+
+    out.commit(total);
+}
+
+
+/**
+ * @return the name of the kernel used by the batch decoder on this CPU:
+ *         "avx512", "avx2" or "scalar"
+ */
+const char* batchDecodeBackend() {
+    return fillKernel().name;
+}
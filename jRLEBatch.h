@@ -0,0 +1,105 @@
+/**
+ * Batch decoding of plain run-length encoded blocks for jRLE, for bulk
+ * decoding of many blocks, such as those of a block container.
+ *
+ * decodeInto() writes each run with its own memset() as soon as it is
+ * read, so text made mostly of short runs spends much of its time in
+ * branches on the run length. The batch decoder instead splits decoding in
+ * two. Runs are first read into a table of a few thousand at a time,
+ * holding each run's char and its offset in the decoded text, a prefix
+ * sum of the run counts. The whole table is then filled in one pass by a
+ * vectorized kernel, which writes each short run with a single store of
+ * its char broadcast across a vector register:
+ * - avx512: a 64-byte store per run, whose excess is overwritten by the
+ *   runs after it, and masked stores writing exactly the chars of the last
+ *   runs of the table, so never writes past the end of the table
+ * - avx2: a 32-byte store per run, like avx512, but with the last runs of
+ *   the table written with memset()
+ * - scalar: a memset() per run, as decodeInto() does
+ * The fastest kernel supported by the CPU is chosen at runtime. Runs longer
+ * than a store are written with memset() by every kernel.
+ *
+ * decodeBatch() decodes many blocks on multiple threads at once. The
+ * decoded length of each block is measured first, and a prefix sum of the
+ * lengths gives the offset of each block in the output, so each block is
+ * decoded straight into its place. ContainerReader::decode() decodes its
+ * blocks with batchDecodeInto().
+ *
+ * For example, to decode three encoded blocks into one output:
+ * std::vector<std::string_view> blocks{ first, second, third };
+ * OutputBuffer out;
+ * decodeBatch(blocks, out);
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_BATCH_H
+#define JRLE_BATCH_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "jRLECodec.h"
+
+
+/**
+ * Run-length decode a string into a caller-supplied span of chars, with the
+ * batch decoder. Equivalent to decodeInto(), with identical errors.
+ *
+ * @param in the encoded text to decode
+ * @param out pointer to space for the decoded text
+ * @param capacity the number of chars available at out. No more than the
+ *                 decoded text is ever written to it.
+ * @return the number of chars written to out
+ * @throw std::invalid_argument if the encoded text is invalid, or decodes
+ *        to more than capacity chars
+ */
+std::size_t batchDecodeInto(std::string_view in, char* out,
+    std::size_t capacity);
+
+
+/**
+ * Run-length decode a string into a caller-supplied span of chars, with the
+ * batch decoder, reporting an error instead of throwing it. Equivalent to
+ * decodeInto(), with identical errors.
+ *
+ * @param in the encoded text to decode
+ * @param out pointer to space for the decoded text
+ * @param capacity the number of chars available at out. No more than the
+ *                 decoded text is ever written to it.
+ * @param error set to an invalidEncoding error if the encoded text is
+ *              invalid, or an outputTooSmall error if it decodes to more
+ *              than capacity chars. Left unchanged otherwise.
+ * @return the number of chars written to out: every run decoded before any
+ *         error
+ */
+std::size_t batchDecodeInto(std::string_view in, char* out,
+    std::size_t capacity, CodecError& error);
+
+
+/**
+ * Run-length decode many plain encoded blocks, writing their decoded texts
+ * one after another to the end of an OutputBuffer. Blocks are measured and
+ * decoded on multiple threads, each directly into its place in the output.
+ *
+ * @param blocks the encoded text of each block, in order
+ * @param out the buffer to append the decoded text to. If a block is
+ *            invalid, the buffer is left unchanged.
+ * @param threads the maximum number of threads to use.
+ *                0 uses one thread per hardware thread.
+ * @throw std::invalid_argument if a block is invalid, or the total decoded
+ *        length is too large
+ */
+void decodeBatch(const std::vector<std::string_view>& blocks,
+    OutputBuffer& out, unsigned threads = 0);
+
+
+/**
+ * @return the name of the kernel used by the batch decoder on this CPU:
+ *         "avx512", "avx2" or "scalar"
+ */
+const char* batchDecodeBackend();
+
+#endif
@@ -0,0 +1,278 @@
+/**
+ * Binary run-length encoding for jRLE, for data of any kind.
+ * See jRLEBinary.h for usage, and for the binary layout.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLEBinary.h"
+#include "jRLEScan.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+
+constexpr char binaryMagic[4] = { 'J', 'R', 'L', 'V' };
+
+// The most bytes a varint holding a 64-bit value can take
+constexpr std::size_t maxVarintLength = 10;
+
+
+/**
+ * Throw an exception describing invalid binary encoded data.
+ *
+ * @param reason description of the error
+ * @param position the position in the encoded data of the error
+ * @throw std::invalid_argument always
+ */
+[[noreturn]] static void invalidBinary(const char* reason,
+        std::size_t position) {
+    throw std::invalid_argument(std::string("Invalid binary encoding. ")
+        + reason + " at position " + std::to_string(position));
+}
+
+
+/**
+ * Write a value as an LEB128 varint.
+ *
+ * @param out pointer to space for maxVarintLength bytes
+ * @param value the value to write
+ * @return the number of bytes written
+ */
+static std::size_t writeVarint(char* out, std::uint64_t value) {
+    std::size_t length{0};
+    while (value >= 0x80) {
+        out[length++] = static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = static_cast<char>(value);
+    return length;
+}
+
+
+/**
+ * Read a token header from binary encoded data.
+ *
+ * @param in the encoded data
+ * @param pos the position of the header, advanced past it
+ * @param literal set to whether the token is a literal, rather than a run
+ * @return the length of the token's decoded data
+ * @throw std::invalid_argument if the header is invalid
+ */
+static std::size_t readHeader(std::string_view in, std::size_t& pos,
+        bool& literal) {
+    const std::size_t start = pos;
+    std::uint64_t header;
+
+    // Almost all headers are a single byte
+    unsigned char byte = static_cast<unsigned char>(in[pos++]);
+    if (byte < 0x80) {
+        header = byte;
+    } else {
+        header = byte & 0x7F;
+        for (unsigned shift{7}; ; shift += 7) {
+            if (pos == in.size()) {
+                invalidBinary("Truncated token header", start);
+            }
+            byte = static_cast<unsigned char>(in[pos++]);
+            // The 10th byte may only hold the top bit of a 64-bit value
+            if (shift == 63 && byte > 1) {
+                invalidBinary("Token header too large", start);
+            }
+            header |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if (byte < 0x80) {
+                break;
+            }
+        }
+    }
+
+    literal = header & 1;
+    header >>= 1;
+    if (header == 0) {
+        invalidBinary("Empty token", start);
+    }
+    if (header > SIZE_MAX) {
+        invalidBinary("Token too long", start);
+    }
+    return static_cast<std::size_t>(header);
+}
+
+
+/**
+ * Check and skip the magic at the start of binary encoded data.
+ *
+ * @param in the encoded data
+ * @return the position of the first token
+ * @throw std::invalid_argument if the magic is missing
+ */
+static std::size_t skipMagic(std::string_view in) {
+    if (!isBinaryEncoded(in)) {
+        invalidBinary("Missing binary format magic", 0);
+    }
+    return sizeof(binaryMagic);
+}
+
+
+/**
+ * Check whether data begins like binary encoded data.
+ *
+ * @param data the data to check
+ * @return true if data starts with the binary format magic
+ */
+bool isBinaryEncoded(std::string_view data) {
+    return data.size() >= sizeof(binaryMagic)
+        && std::memcmp(data.data(), binaryMagic, sizeof(binaryMagic)) == 0;
+}
+
+
+/**
+ * Write a literal token.
+ *
+ * @param begin pointer to the first byte of the literal
+ * @param end pointer to the byte after the literal
+ * @param out the buffer to append the token to
+ */
+static void writeLiteral(const char* begin, const char* end,
+        OutputBuffer& out) {
+    const std::size_t length = end - begin;
+    if (length == 0) {
+        return;
+    }
+    char* token = out.prepare(maxVarintLength + length);
+    std::size_t headerLength = writeVarint(token,
+        (static_cast<std::uint64_t>(length) << 1) | 1);
+    std::memcpy(token + headerLength, begin, length);
+    out.commit(headerLength + length);
+}
+
+
+/**
+ * Run-length encode data of any kind into the binary format, writing the
+ * result to the end of an OutputBuffer.
+ *
+ * @param in the unencoded data to encode
+ * @param out the buffer to append the encoded data to
+ */
+void encodeBinary(std::string_view in, OutputBuffer& out) {
+    out.append(std::string_view(binaryMagic, sizeof(binaryMagic)));
+
+    const char* pos = in.data();
+    const char* end = pos + in.size();
+    // The start of the bytes not yet written, which will form a literal
+    const char* literalStart = pos;
+
+    while (pos < end) {
+        const char* runEnd = findRunEnd(pos, end);
+        const std::size_t length = runEnd - pos;
+
+        // Short runs are left to join the literal
+        if (length >= minBinaryRunLength) {
+            writeLiteral(literalStart, pos, out);
+
+            char* token = out.prepare(maxVarintLength + 1);
+            std::size_t headerLength = writeVarint(token,
+                static_cast<std::uint64_t>(length) << 1);
+            token[headerLength] = *pos;
+            out.commit(headerLength + 1);
+
+            literalStart = runEnd;
+        }
+        pos = runEnd;
+    }
+
+    writeLiteral(literalStart, end, out);
+}
+
+
+/**
+ * Calculate the exact length of binary encoded data once decoded, without
+ * decoding it. Literals are skipped over without being read.
+ *
+ * @param in the encoded data to measure
+ * @return the number of bytes in the decoded data
+ * @throw std::invalid_argument if the encoded data is invalid
+ */
+std::size_t binaryDecodedLength(std::string_view in) {
+    std::size_t pos = skipMagic(in);
+    std::size_t total{0};
+    bool literal;
+
+    while (pos < in.size()) {
+        const std::size_t start = pos;
+        std::size_t length = readHeader(in, pos, literal);
+        std::size_t encodedLength = literal ? length : 1;
+        if (encodedLength > in.size() - pos) {
+            invalidBinary("Truncated token", start);
+        }
+        if (length > SIZE_MAX - total) {
+            invalidBinary("Decoded length too large", start);
+        }
+        pos += encodedLength;
+        total += length;
+    }
+
+    return total;
+}
+
+
+/**
+ * Run-length decode binary encoded data, writing the result to the end of
+ * an OutputBuffer. Space for the whole result is made exactly once.
+ *
+ * @param in the encoded data to decode
+ * @param out the buffer to append the decoded data to. If the encoded data
+ *            is invalid, the buffer is left unchanged.
+ * @throw std::invalid_argument if the encoded data is invalid
+ */
+void decodeBinary(std::string_view in, OutputBuffer& out) {
+    const std::size_t length = binaryDecodedLength(in);
+    if (length == 0) {
+        return;
+    }
+    out.commit(decodeBinaryInto(in, out.prepare(length), length));
+}
+
+
+/**
+ * Run-length decode binary encoded data into a caller-supplied span of bytes.
+ *
+ * @param in the encoded data to decode
+ * @param out pointer to space for the decoded data
+ * @param capacity the number of bytes available at out
+ * @return the number of bytes written to out
+ * @throw std::invalid_argument if the encoded data is invalid, or decodes
+ *        to more than capacity bytes
+ */
+std::size_t decodeBinaryInto(std::string_view in, char* out,
+        std::size_t capacity) {
+    std::size_t pos = skipMagic(in);
+    std::size_t written{0};
+    bool literal;
+
+    while (pos < in.size()) {
+        const std::size_t start = pos;
+        std::size_t length = readHeader(in, pos, literal);
+        if (length > capacity - written) {
+            invalidBinary("Decoded data too long", start);
+        }
+
+        if (literal) {
+            if (length > in.size() - pos) {
+                invalidBinary("Truncated token", start);
+            }
+            std::memcpy(out + written, in.data() + pos, length);
+            pos += length;
+        } else {
+            if (pos == in.size()) {
+                invalidBinary("Truncated token", start);
+            }
+            std::memset(out + written, in[pos], length);
+            pos++;
+        }
+        written += length;
+    }
+
+    return written;
+}
@@ -0,0 +1,118 @@
+/**
+ * Binary run-length encoding for jRLE, for data of any kind.
+ *
+ * The text format counts runs in decimal, and escapes digits and '#' chars
+ * so that the counts can be told apart from the data. This makes it
+ * unsuitable for binary data, and it doubles the size of text with no runs.
+ * The binary format instead describes the data as a sequence of runs and
+ * literals, each prefixed by its length as an LEB128 varint.
+ *
+ *                  == Binary Layout ==
+ * - "JRLV" magic
+ * - Tokens, in order. Each token starts with a varint header: the token's
+ *   length in bytes shifted left by 1, with its kind in the low bit.
+ *   The length must not be 0.
+ *   + Kind 0 (run): followed by a single byte, repeated length times
+ *   + Kind 1 (literal): followed by length bytes, copied as they are
+ *
+ * Varints store 7 bits of the value in each byte, least significant first,
+ * with the high bit set in every byte but the last. For example, a run of
+ * 300 'a' chars is the header 600 (0xD8 0x04), followed by 'a'.
+ *
+ * For example, to encode and decode a buffer:
+ * OutputBuffer encoded;
+ * encodeBinary(data, encoded);
+ * OutputBuffer decoded;
+ * decodeBinary(encoded.view(), decoded);
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_BINARY_H
+#define JRLE_BINARY_H
+
+#include <cstddef>
+#include <string_view>
+
+#include "jRLECodec.h"
+
+
+/**
+ * The shortest run written as a run token. Shorter runs are written as part
+ * of a literal, where they take no more space.
+ */
+constexpr std::size_t minBinaryRunLength = 3;
+
+
+/**
+ * An upper bound on the length of binary encoded data.
+ *
+ * @param length the number of bytes of unencoded data
+ * @return the capacity an OutputBuffer needs to encode the data
+ */
+constexpr std::size_t binaryEncodedLengthBound(std::size_t length) {
+    // Every run token is shorter than its run, paying for the first byte of
+    // the following literal's header. Longer headers cost less than 3 bytes
+    // for every 128 bytes of literal. The rest covers the magic, and the
+    // space encodeBinary() prepares for its longest token header.
+    return length + length / 32 + 32;
+}
+
+
+/**
+ * Check whether data begins like binary encoded data.
+ *
+ * @param data the data to check
+ * @return true if data starts with the binary format magic
+ */
+bool isBinaryEncoded(std::string_view data);
+
+
+/**
+ * Run-length encode data of any kind into the binary format, writing the
+ * result to the end of an OutputBuffer.
+ *
+ * @param in the unencoded data to encode
+ * @param out the buffer to append the encoded data to
+ */
+void encodeBinary(std::string_view in, OutputBuffer& out);
+
+
+/**
+ * Calculate the exact length of binary encoded data once decoded, without
+ * decoding it. Literals are skipped over without being read.
+ *
+ * @param in the encoded data to measure
+ * @return the number of bytes in the decoded data
+ * @throw std::invalid_argument if the encoded data is invalid
+ */
+std::size_t binaryDecodedLength(std::string_view in);
+
+
+/**
+ * Run-length decode binary encoded data, writing the result to the end of
+ * an OutputBuffer. Space for the whole result is made exactly once.
+ *
+ * @param in the encoded data to decode
+ * @param out the buffer to append the decoded data to. If the encoded data
+ *            is invalid, the buffer is left unchanged.
+ * @throw std::invalid_argument if the encoded data is invalid
+ */
+void decodeBinary(std::string_view in, OutputBuffer& out);
+
+
+/**
+ * Run-length decode binary encoded data into a caller-supplied span of bytes.
+ *
+ * @param in the encoded data to decode
+ * @param out pointer to space for the decoded data
+ * @param capacity the number of bytes available at out
+ * @return the number of bytes written to out
+ * @throw std::invalid_argument if the encoded data is invalid, or decodes
+ *        to more than capacity bytes
+ */
+std::size_t decodeBinaryInto(std::string_view in, char* out,
+    std::size_t capacity);
+
+#endif
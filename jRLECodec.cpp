@@ -0,0 +1,386 @@
+/**
+ * Single-pass run-length encoding and decoding for jRLE.
+ * See jRLECodec.h for usage.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLECodec.h"
+#include "jRLEPolicy.h"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+
+static_assert(DefaultRLE::maxETokenLength == maxETokenLength,
+    "maxETokenLength must fit the longest eToken of the default format");
+
+
+/**
+ * Ensure the buffer can hold at least capacity chars without reallocating.
+ *
+ * @param capacity the total number of chars to reserve space for
+ * @throw std::length_error if the buffer writes into caller-owned memory,
+ *        and capacity exceeds it
+ */
+void OutputBuffer::reserve(std::size_t capacity) {
+    if (capacity <= allocated) {
+        return;
+    }
+    if (external) {
+        throw std::length_error("Output exceeds buffer capacity of "
+            + std::to_string(allocated));
+    }
+    std::unique_ptr<char[]> newStorage{ new char[capacity] };
+    if (length != 0) {
+        std::memcpy(newStorage.get(), storage, length);
+    }
+    owned = std::move(newStorage);
+    storage = owned.get();
+    allocated = capacity;
+}
+
+
+/**
+ * Add a sequence of chars to the end of the buffer.
+ *
+ * @param text the chars to add
+ */
+void OutputBuffer::append(std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+    std::memcpy(prepare(text.size()), text.data(), text.size());
+    length += text.size();
+}
+
+
+/**
+ * Reallocate the buffer with space for at least count more chars.
+ * Capacity at least doubles, so repeated small writes are amortized.
+ *
+ * @param count the number of chars to make space for
+ */
+void OutputBuffer::grow(std::size_t count) {
+    std::size_t newCapacity = allocated * 2;
+    if (newCapacity < length + count) {
+        newCapacity = length + count;
+    }
+    if (newCapacity < 64) {
+        newCapacity = 64;
+    }
+    reserve(newCapacity);
+}
+
+
+/**
+ * Write the eToken for a single run of chars.
+ * This is the encoding applied by encodeTokens() to each of its tokens.
+ *
+ * @param out pointer to space for at least eTokenLength(c, count,
+ *            prevRunDigit) chars. maxETokenLength is always enough.
+ * @param c the char the run consists of
+ * @param count the number of chars in the run. Must be at least 1.
+ * @param prevRunDigit whether the previous run consisted of digits
+ * @return the number of chars written to out
+ */
+std::size_t writeEToken(char* out, char c, std::size_t count,
+        bool prevRunDigit) {
+    return DefaultRLE::writeEToken(out, c, count, prevRunDigit);
+}
+
+
+/**
+ * Calculate the length of the eToken for a single run of chars, without
+ * writing it.
+ *
+ * @param c the char the run consists of
+ * @param count the number of chars in the run. Must be at least 1.
+ * @param prevRunDigit whether the previous run consisted of digits
+ * @return the number of chars writeEToken() would write
+ */
+std::size_t eTokenLength(char c, std::size_t count, bool prevRunDigit) {
+    return DefaultRLE::eTokenLength(c, count, prevRunDigit);
+}
+
+
+/**
+ * Calculate the exact length of a string once run-length encoded, without
+ * encoding it.
+ *
+ * @param in the unencoded text to measure
+ * @param prevRunDigit whether the text before in ended with a run of digits
+ * @return the number of chars in the encoded text
+ */
+std::size_t encodedLength(std::string_view in, bool prevRunDigit) {
+    return DefaultRLE::encodedLength(in, prevRunDigit);
+}
+
+
+/**
+ * Estimate how much a string would grow or shrink once run-length encoded,
+ * by measuring the encoded length of a few evenly spaced samples of it.
+ * Short strings are measured exactly. This is far cheaper than encoding the
+ * whole string, so can be used to decide whether to encode it at all.
+ *
+ * @param in the unencoded text to estimate the encoding of
+ * @param samples the number of samples to measure. Must not be 0.
+ * @param sampleLength the number of chars in each sample
+ * @return the estimated ratio of encoded length to unencoded length. Above 1
+ *         if the text is expected to expand, or 0 if in is empty.
+ */
+double estimateEncodedRatio(std::string_view in, std::size_t samples,
+        std::size_t sampleLength) {
+    if (in.empty()) {
+        return 0;
+    }
+    if (sampleLength == 0 || in.size() / samples <= sampleLength) {
+        return static_cast<double>(encodedLength(in))
+            / static_cast<double>(in.size());
+    }
+
+    // Spread the samples from the very start of the text to its very end.
+    // Runs cut by the ends of a sample are measured as shorter than they
+    // are, so text of only long runs may be overestimated.
+    const std::size_t spacing = samples == 1 ? 0
+        : (in.size() - sampleLength) / (samples - 1);
+    std::size_t measured{0};
+    for (std::size_t i{0}; i < samples; i++) {
+        measured += encodedLength(in.substr(i * spacing, sampleLength));
+    }
+    return static_cast<double>(measured)
+        / static_cast<double>(samples * sampleLength);
+}
+
+
+/**
+ * Run-length encode a string, writing the result to the end of an
+ * OutputBuffer. Space for the whole result is made exactly once: for
+ * encodedLengthBound() chars if the buffer can hold them, otherwise for
+ * exactly encodedLength() chars.
+ * Equivalent to vectorConcatenate(encodeTokens(tokenizeUnencoded(in)))
+ *
+ * Text may be encoded in pieces, provided each piece starts a new run,
+ * by passing whether the previous piece ended with a digit.
+ *
+ * @param in the unencoded text to encode
+ * @param out the buffer to append the encoded text to
+ * @param prevRunDigit whether the text before in ended with a run of digits
+ */
+void encode(std::string_view in, OutputBuffer& out, bool prevRunDigit) {
+    DefaultRLE::encode(in, out, prevRunDigit);
+}
+
+
+/**
+ * Run-length encode a string in a single pass, into a caller-supplied span
+ * of chars.
+ *
+ * @param in the unencoded text to encode
+ * @param out pointer to space for the encoded text
+ * @param capacity the number of chars available at out. encodedLength(in)
+ *                 is always enough.
+ * @param prevRunDigit whether the text before in ended with a run of digits
+ * @return the number of chars written to out
+ * @throw std::length_error if the encoded text is longer than capacity chars
+ */
+std::size_t encodeInto(std::string_view in, char* out, std::size_t capacity,
+        bool prevRunDigit) {
+    return DefaultRLE::encodeInto(in, out, capacity, prevRunDigit);
+}
+
+
+/**
+ * Run-length encode a string in a single pass, into a caller-supplied span
+ * of chars, reporting an error instead of throwing it.
+ *
+ * @param in the unencoded text to encode
+ * @param out pointer to space for the encoded text
+ * @param capacity the number of chars available at out
+ * @param prevRunDigit whether the text before in ended with a run of digits
+ * @param error set to an outputTooSmall error, at the position in in of the
+ *              first run that did not fit, if the encoded text is longer
+ *              than capacity chars. Left unchanged otherwise.
+ * @return the number of chars written to out: every eToken that fit
+ */
+std::size_t encodeInto(std::string_view in, char* out, std::size_t capacity,
+        bool prevRunDigit, CodecError& error) {
+    return DefaultRLE::encodeInto(in, out, capacity, prevRunDigit, error);
+}
+
+
+/**
+ * @param text the encoded text to read. Must outlive the reader.
+ * @param pos the position in text to start reading from
+ * @param inLongSeq whether pos lies within a long sequence
+ */
+EncodedRunReader::EncodedRunReader(std::string_view text, std::size_t pos,
+        bool inLongSeq) :
+        text(text),
+        pos{pos},
+        longSeq{inLongSeq} {}
+
+
+/**
+ * Read the next run from the encoded text.
+ *
+ * @param count set to the number of chars in the run
+ * @param c set to the char the run consists of
+ * @return true if a run was read, false if the end of the text was reached
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+bool EncodedRunReader::next(std::size_t& count, char& c) {
+    return DefaultRLE::readRun(text, pos, longSeq, count, c);
+}
+
+
+/**
+ * @return the position in the text of the next unread char
+ */
+std::size_t EncodedRunReader::position() const {
+    return pos;
+}
+
+
+/**
+ * @return whether the next unread char lies within a long sequence
+ */
+bool EncodedRunReader::inLongSeq() const {
+    return longSeq;
+}
+
+
+/**
+ * Calculate the exact length of run-length encoded text once decoded,
+ * without decoding it.
+ *
+ * @param in the encoded text to measure
+ * @return the number of chars in the decoded text
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+std::size_t decodedLength(std::string_view in) {
+    return DefaultRLE::decodedLength(in);
+}
+
+
+/**
+ * Calculate the exact length of run-length encoded text once decoded,
+ * without decoding it, reporting an error instead of throwing it.
+ *
+ * @param in the encoded text to measure
+ * @param error set to an invalidEncoding error if the encoded text is
+ *              invalid. Left unchanged otherwise.
+ * @return the number of chars in the decoded text, or 0 if it is invalid
+ */
+std::size_t decodedLength(std::string_view in, CodecError& error) {
+    return DefaultRLE::decodedLength(in, error);
+}
+
+
+/**
+ * Check whether run-length encoded text is valid, without decoding it.
+ * Accepts exactly the text that decodedLength() accepts, with a single
+ * table lookup per char, so checks untrusted text much faster than
+ * decoding it.
+ *
+ * @param in the encoded text to check
+ * @param error set to an invalidEncoding error if the encoded text is
+ *              invalid. Left unchanged otherwise.
+ * @return true if the encoded text is valid
+ */
+bool validateEncoded(std::string_view in, CodecError& error) {
+    return DefaultRLE::validate(in, error);
+}
+
+
+/**
+ * Run-length decode a string in a single pass, writing the result to the end
+ * of an OutputBuffer. Space for the whole result is made exactly once.
+ * Accepts the same encoded text as tokenizeEncoded(), including a long
+ * sequence of digit chars that ends the text and a redundant # after a #
+ * run, and gives the same result as
+ * vectorConcatenate(decodeTokens(tokenizeEncoded(in))). Only the wording
+ * of errors differs.
+ *
+ * @param in the encoded text to decode
+ * @param out the buffer to append the decoded text to. If the encoded text
+ *            is invalid, the buffer is left unchanged.
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+void decode(std::string_view in, OutputBuffer& out) {
+    DefaultRLE::decode(in, out);
+}
+
+
+/**
+ * Run-length decode a string into a caller-supplied span of chars.
+ *
+ * @param in the encoded text to decode
+ * @param out pointer to space for the decoded text
+ * @param capacity the number of chars available at out
+ * @return the number of chars written to out
+ * @throw std::invalid_argument if the encoded text is invalid, or decodes
+ *        to more than capacity chars
+ */
+std::size_t decodeInto(std::string_view in, char* out, std::size_t capacity) {
+    return DefaultRLE::decodeInto(in, out, capacity);
+}
+
+
+/**
+ * Run-length decode a string into a caller-supplied span of chars,
+ * reporting an error instead of throwing it.
+ *
+ * @param in the encoded text to decode
+ * @param out pointer to space for the decoded text
+ * @param capacity the number of chars available at out
+ * @param error set to an invalidEncoding error if the encoded text is
+ *              invalid, or an outputTooSmall error if it decodes to more
+ *              than capacity chars. Left unchanged otherwise.
+ * @return the number of chars written to out: every run decoded before any
+ *         error
+ */
+std::size_t decodeInto(std::string_view in, char* out, std::size_t capacity,
+        CodecError& error) {
+    return DefaultRLE::decodeInto(in, out, capacity, error);
+}
+
+
+/**
+ * Decode the runs that fall within a range of the decoded text, skipping
+ * those before it and stopping once the range is filled.
+ *
+ * @param reader reader positioned at the start of a run
+ * @param runStart the position in the decoded text of the reader's next run.
+ *                 Must be no greater than offset.
+ * @param offset the position in the decoded text of the first char to decode
+ * @param length the number of chars to decode
+ * @param out pointer to space for length chars
+ * @return the position in the decoded text after the last run read. Less
+ *         than offset + length if the encoded text ended before the range.
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+std::size_t decodeRunsInRange(EncodedRunReader& reader, std::size_t runStart,
+        std::size_t offset, std::size_t length, char* out) {
+    const std::size_t rangeEnd = offset + length;
+    std::size_t count;
+    char c;
+
+    while (runStart < rangeEnd && reader.next(count, c)) {
+        if (count > std::numeric_limits<std::size_t>::max() - runStart) {
+            invalidEncoding("Decoded length too large", reader.position());
+        }
+        const std::size_t runEnd = runStart + count;
+        // Copy only the part of the run that overlaps the range
+        if (runEnd > offset) {
+            const std::size_t from = runStart > offset ? runStart : offset;
+            const std::size_t to = runEnd < rangeEnd ? runEnd : rangeEnd;
+            std::memset(out + (from - offset), c, to - from);
+        }
+        runStart = runEnd;
+    }
+
+    return runStart;
+}
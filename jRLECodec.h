@@ -0,0 +1,501 @@
+/**
+ * Single-pass run-length encoding and decoding for jRLE.
+ *
+ * The three-stage API in jRLE.h allocates a string for every token at every
+ * stage. The functions in this header instead find runs and write their
+ * eTokens directly into a caller-supplied OutputBuffer, with no per-token
+ * allocations. The output is identical to that of the three-stage API.
+ *
+ * For example, to encode "aaa":
+ * OutputBuffer out;
+ * encode("aaa", out);
+ * std::string_view encoded = out.view();  // "3a"
+ *
+ * Decoding first measures the exact decoded length, so that the output
+ * is allocated only once, then writes each run directly into it:
+ * OutputBuffer decoded;
+ * decode("3a", decoded);  // "aaa"
+ *
+ * An OutputBuffer may be reused between calls, and will only allocate when
+ * its capacity is exceeded. Reserve capacity up front to avoid this entirely.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_CODEC_H
+#define JRLE_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+
+/**
+ * The longest possible eToken: '#', a 20-digit char count, the char, and '#'
+ */
+constexpr std::size_t maxETokenLength = 23;
+
+
+/**
+ * An upper bound on the length of encoded text, for sizing output without
+ * measuring it first. The longest eToken per unencoded char is "#1##", for a
+ * single '#' following a digit. See encodedLength() for the exact length.
+ *
+ * @param length the number of chars of unencoded text
+ * @return the capacity an OutputBuffer needs to encode the text
+ */
+constexpr std::size_t encodedLengthBound(std::size_t length) {
+    return 4 * length;
+}
+
+
+/**
+ * A growable, contiguous buffer of chars, for en/decoders to write into.
+ * Unlike std::string, space can be prepared and then written directly,
+ * without first being initialized.
+ *
+ * A buffer may instead write into memory owned by the caller, such as a
+ * memory-mapped file. Such a buffer cannot grow beyond its capacity.
+ */
+class OutputBuffer {
+public:
+    OutputBuffer() = default;
+
+    /**
+     * @param capacity the number of chars to reserve space for
+     */
+    explicit OutputBuffer(std::size_t capacity) {
+        reserve(capacity);
+    }
+
+    /**
+     * Create an empty buffer that writes into caller-owned memory.
+     *
+     * @param memory pointer to the memory to write into. Must outlive the
+     *               buffer.
+     * @param capacity the number of chars available at memory
+     */
+    OutputBuffer(char* memory, std::size_t capacity) :
+            storage{memory},
+            allocated{capacity},
+            external{true} {}
+
+    OutputBuffer(OutputBuffer&&) = default;
+    OutputBuffer& operator=(OutputBuffer&&) = default;
+
+    /**
+     * Ensure the buffer can hold at least capacity chars without reallocating.
+     *
+     * @param capacity the total number of chars to reserve space for
+     * @throw std::length_error if the buffer writes into caller-owned memory,
+     *        and capacity exceeds it
+     */
+    void reserve(std::size_t capacity);
+
+    /**
+     * Remove all chars from the buffer, keeping its capacity.
+     */
+    void clear() {
+        length = 0;
+    }
+
+    /**
+     * Ensure space exists for count more chars, and return a pointer to it.
+     * The chars do not become part of the buffer until commit() is called.
+     *
+     * @param count the number of chars to prepare space for
+     * @return pointer to the first char after the end of the buffer
+     * @throw std::length_error if the buffer writes into caller-owned memory,
+     *        and count chars do not fit
+     */
+    char* prepare(std::size_t count) {
+        if (allocated - length < count) {
+            grow(count);
+        }
+        return storage + length;
+    }
+
+    /**
+     * Add count chars, already written to space from prepare(), to the buffer.
+     *
+     * @param count the number of written chars
+     */
+    void commit(std::size_t count) {
+        length += count;
+    }
+
+    /**
+     * Add a single char to the end of the buffer.
+     *
+     * @param c the char to add
+     */
+    void put(char c) {
+        *prepare(1) = c;
+        length++;
+    }
+
+    /**
+     * Add a sequence of chars to the end of the buffer.
+     *
+     * @param text the chars to add
+     */
+    void append(std::string_view text);
+
+    /**
+     * @return pointer to the first char in the buffer
+     */
+    const char* data() const {
+        return storage;
+    }
+
+    /**
+     * @return the number of chars in the buffer
+     */
+    std::size_t size() const {
+        return length;
+    }
+
+    /**
+     * @return the number of chars the buffer can hold without reallocating
+     */
+    std::size_t capacity() const {
+        return allocated;
+    }
+
+    /**
+     * @return true if the buffer can grow beyond its capacity, false if it
+     * writes into caller-owned memory
+     */
+    bool growable() const {
+        return !external;
+    }
+
+    /**
+     * @return a view of all chars in the buffer, invalidated by any
+     * subsequent change to the buffer
+     */
+    std::string_view view() const {
+        return { storage, length };
+    }
+
+    /**
+     * @return a copy of the buffer contents as an std::string
+     */
+    std::string str() const {
+        return std::string(view());
+    }
+
+private:
+    void grow(std::size_t count);
+
+    // Memory allocated by the buffer. Empty for caller-owned memory.
+    std::unique_ptr<char[]> owned;
+    char* storage{nullptr};
+    std::size_t length{0};
+    std::size_t allocated{0};
+    bool external{false};
+};
+
+
+/**
+ * A single run of one or more of a single char - the compact equivalent of
+ * a dToken, or of the run an eToken describes.
+ * Runs longer than a count can hold are split into consecutive Runs of the
+ * same char.
+ */
+struct Run {
+    std::uint32_t count;
+    char byte;
+};
+
+
+/**
+ * The outcome of an en/decode that reports errors instead of throwing them
+ */
+enum class CodecStatus {
+    ok,
+    // The output did not fit in the space given for it
+    outputTooSmall,
+    // The encoded text was invalid
+    invalidEncoding
+};
+
+
+/**
+ * Describes why an en/decode failed, for the overloads of the en/decoders
+ * that report errors instead of throwing them
+ */
+struct CodecError {
+    CodecStatus status{CodecStatus::ok};
+    // Description of the error, or null if there is none
+    const char* reason{nullptr};
+    // The position in the input of the error
+    std::size_t position{0};
+};
+
+
+/**
+ * Write the eToken for a single run of chars.
+ * This is the encoding applied by encodeTokens() to each of its tokens.
+ *
+ * @param out pointer to space for at least eTokenLength(c, count,
+ *            prevRunDigit) chars. maxETokenLength is always enough.
+ * @param c the char the run consists of
+ * @param count the number of chars in the run. Must be at least 1.
+ * @param prevRunDigit whether the previous run consisted of digits
+ * @return the number of chars written to out
+ */
+std::size_t writeEToken(char* out, char c, std::size_t count,
+    bool prevRunDigit);
+
+
+/**
+ * Calculate the length of the eToken for a single run of chars, without
+ * writing it.
+ *
+ * @param c the char the run consists of
+ * @param count the number of chars in the run. Must be at least 1.
+ * @param prevRunDigit whether the previous run consisted of digits
+ * @return the number of chars writeEToken() would write
+ */
+std::size_t eTokenLength(char c, std::size_t count, bool prevRunDigit);
+
+
+/**
+ * Calculate the exact length of a string once run-length encoded, without
+ * encoding it.
+ *
+ * @param in the unencoded text to measure
+ * @param prevRunDigit whether the text before in ended with a run of digits
+ * @return the number of chars in the encoded text
+ */
+std::size_t encodedLength(std::string_view in, bool prevRunDigit = false);
+
+
+/**
+ * The default number of samples taken by estimateEncodedRatio()
+ */
+constexpr std::size_t defaultRatioSamples = 8;
+
+
+/**
+ * The default length in chars of each sample taken by estimateEncodedRatio()
+ */
+constexpr std::size_t defaultRatioSampleLength = 4096;
+
+
+/**
+ * Estimate how much a string would grow or shrink once run-length encoded,
+ * by measuring the encoded length of a few evenly spaced samples of it.
+ * Short strings are measured exactly. This is far cheaper than encoding the
+ * whole string, so can be used to decide whether to encode it at all.
+ *
+ * @param in the unencoded text to estimate the encoding of
+ * @param samples the number of samples to measure. Must not be 0.
+ * @param sampleLength the number of chars in each sample
+ * @return the estimated ratio of encoded length to unencoded length. Above 1
+ *         if the text is expected to expand, or 0 if in is empty.
+ */
+double estimateEncodedRatio(std::string_view in,
+    std::size_t samples = defaultRatioSamples,
+    std::size_t sampleLength = defaultRatioSampleLength);
+
+
+/**
+ * Run-length encode a string, writing the result to the end of an
+ * OutputBuffer. Space for the whole result is made exactly once: for
+ * encodedLengthBound() chars if the buffer can hold them, otherwise for
+ * exactly encodedLength() chars.
+ * Equivalent to vectorConcatenate(encodeTokens(tokenizeUnencoded(in)))
+ *
+ * Text may be encoded in pieces, provided each piece starts a new run,
+ * by passing whether the previous piece ended with a digit.
+ *
+ * @param in the unencoded text to encode
+ * @param out the buffer to append the encoded text to
+ * @param prevRunDigit whether the text before in ended with a run of digits
+ */
+void encode(std::string_view in, OutputBuffer& out, bool prevRunDigit = false);
+
+
+/**
+ * Run-length encode a string in a single pass, into a caller-supplied span
+ * of chars.
+ *
+ * @param in the unencoded text to encode
+ * @param out pointer to space for the encoded text
+ * @param capacity the number of chars available at out. encodedLength(in)
+ *                 is always enough.
+ * @param prevRunDigit whether the text before in ended with a run of digits
+ * @return the number of chars written to out
+ * @throw std::length_error if the encoded text is longer than capacity chars
+ */
+std::size_t encodeInto(std::string_view in, char* out, std::size_t capacity,
+    bool prevRunDigit = false);
+
+
+/**
+ * Run-length encode a string in a single pass, into a caller-supplied span
+ * of chars, reporting an error instead of throwing it.
+ *
+ * @param in the unencoded text to encode
+ * @param out pointer to space for the encoded text
+ * @param capacity the number of chars available at out
+ * @param prevRunDigit whether the text before in ended with a run of digits
+ * @param error set to an outputTooSmall error, at the position in in of the
+ *              first run that did not fit, if the encoded text is longer
+ *              than capacity chars. Left unchanged otherwise.
+ * @return the number of chars written to out: every eToken that fit
+ */
+std::size_t encodeInto(std::string_view in, char* out, std::size_t capacity,
+    bool prevRunDigit, CodecError& error);
+
+
+/**
+ * Reads the runs described by run-length encoded text, one at a time and
+ * without allocating. Accepts the same encoded text as tokenizeEncoded(),
+ * including a long sequence of digit chars that ends the text and a
+ * redundant # after a # run, and reads the same runs from it.
+ */
+class EncodedRunReader {
+public:
+    /**
+     * @param text the encoded text to read. Must outlive the reader.
+     * @param pos the position in text to start reading from
+     * @param inLongSeq whether pos lies within a long sequence
+     */
+    explicit EncodedRunReader(std::string_view text, std::size_t pos = 0,
+        bool inLongSeq = false);
+
+    /**
+     * Read the next run from the encoded text.
+     *
+     * @param count set to the number of chars in the run
+     * @param c set to the char the run consists of
+     * @return true if a run was read, false if the end of the text was reached
+     * @throw std::invalid_argument if the encoded text is invalid
+     */
+    bool next(std::size_t& count, char& c);
+
+    /**
+     * @return the position in the text of the next unread char
+     */
+    std::size_t position() const;
+
+    /**
+     * @return whether the next unread char lies within a long sequence
+     */
+    bool inLongSeq() const;
+
+private:
+    std::string_view text;
+    std::size_t pos;
+    bool longSeq;
+};
+
+
+/**
+ * Calculate the exact length of run-length encoded text once decoded,
+ * without decoding it.
+ *
+ * @param in the encoded text to measure
+ * @return the number of chars in the decoded text
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+std::size_t decodedLength(std::string_view in);
+
+
+/**
+ * Calculate the exact length of run-length encoded text once decoded,
+ * without decoding it, reporting an error instead of throwing it.
+ *
+ * @param in the encoded text to measure
+ * @param error set to an invalidEncoding error if the encoded text is
+ *              invalid. Left unchanged otherwise.
+ * @return the number of chars in the decoded text, or 0 if it is invalid
+ */
+std::size_t decodedLength(std::string_view in, CodecError& error);
+
+
+/**
+ * Check whether run-length encoded text is valid, without decoding it.
+ * Accepts exactly the text that decodedLength() accepts, with a single
+ * table lookup per char, so checks untrusted text much faster than
+ * decoding it.
+ *
+ * @param in the encoded text to check
+ * @param error set to an invalidEncoding error if the encoded text is
+ *              invalid. Left unchanged otherwise.
+ * @return true if the encoded text is valid
+ */
+bool validateEncoded(std::string_view in, CodecError& error);
+
+
+/**
+ * Run-length decode a string in a single pass, writing the result to the end
+ * of an OutputBuffer. Space for the whole result is made exactly once.
+ * Accepts the same encoded text as tokenizeEncoded(), including a long
+ * sequence of digit chars that ends the text and a redundant # after a #
+ * run, and gives the same result as
+ * vectorConcatenate(decodeTokens(tokenizeEncoded(in))). Only the wording
+ * of errors differs.
+ *
+ * @param in the encoded text to decode
+ * @param out the buffer to append the decoded text to. If the encoded text
+ *            is invalid, the buffer is left unchanged.
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+void decode(std::string_view in, OutputBuffer& out);
+
+
+/**
+ * Run-length decode a string into a caller-supplied span of chars.
+ *
+ * @param in the encoded text to decode
+ * @param out pointer to space for the decoded text
+ * @param capacity the number of chars available at out
+ * @return the number of chars written to out
+ * @throw std::invalid_argument if the encoded text is invalid, or decodes
+ *        to more than capacity chars
+ */
+std::size_t decodeInto(std::string_view in, char* out, std::size_t capacity);
+
+
+/**
+ * Run-length decode a string into a caller-supplied span of chars,
+ * reporting an error instead of throwing it.
+ *
+ * @param in the encoded text to decode
+ * @param out pointer to space for the decoded text
+ * @param capacity the number of chars available at out
+ * @param error set to an invalidEncoding error if the encoded text is
+ *              invalid, or an outputTooSmall error if it decodes to more
+ *              than capacity chars. Left unchanged otherwise.
+ * @return the number of chars written to out: every run decoded before any
+ *         error
+ */
+std::size_t decodeInto(std::string_view in, char* out, std::size_t capacity,
+    CodecError& error);
+
+
+/**
+ * Decode the runs that fall within a range of the decoded text, skipping
+ * those before it and stopping once the range is filled.
+ *
+ * @param reader reader positioned at the start of a run
+ * @param runStart the position in the decoded text of the reader's next run.
+ *                 Must be no greater than offset.
+ * @param offset the position in the decoded text of the first char to decode
+ * @param length the number of chars to decode
+ * @param out pointer to space for length chars
+ * @return the position in the decoded text after the last run read. Less
+ *         than offset + length if the encoded text ended before the range.
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+std::size_t decodeRunsInRange(EncodedRunReader& reader, std::size_t runStart,
+    std::size_t offset, std::size_t length, char* out);
+
+#endif
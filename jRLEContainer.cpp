@@ -0,0 +1,405 @@
+/**
+ * Seekable block container format for jRLE.
+ * See jRLEContainer.h for usage, and for the container layout.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLEContainer.h"
+#include "jRLEBatch.h"
+#include "jRLEThreads.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+
+// Sizes in bytes of each part of the container layout
+constexpr std::size_t containerHeaderSize = 16;
+constexpr std::size_t containerEntrySize = 40;
+constexpr std::size_t containerFooterSize = 24;
+
+constexpr char containerMagic[4] = { 'J', 'R', 'L', 'B' };
+constexpr std::uint8_t containerVersion = 1;
+
+
+/**
+ * Write an unsigned 64-bit integer in little-endian byte order.
+ *
+ * @param out pointer to space for 8 bytes
+ * @param value the integer to write
+ */
+static void putU64(char* out, std::uint64_t value) {
+    for (int i{0}; i < 8; i++) {
+        out[i] = static_cast<char>(value >> (8 * i));
+    }
+}
+
+
+/**
+ * Read an unsigned 64-bit integer in little-endian byte order.
+ *
+ * @param in pointer to 8 bytes
+ * @return the integer read
+ */
+static std::uint64_t getU64(const char* in) {
+    std::uint64_t value{0};
+    for (int i{0}; i < 8; i++) {
+        value |= static_cast<std::uint64_t>(
+            static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+
+/**
+ * Throw an exception describing an invalid container.
+ *
+ * @param reason description of the error
+ * @throw std::invalid_argument always
+ */
+[[noreturn]] static void invalidContainer(const std::string& reason) {
+    throw std::invalid_argument("Invalid container. " + reason);
+}
+
+
+/**
+ * Check whether data begins like a container, rather than like encoded text.
+ *
+ * @param data the data to check
+ * @return true if data starts with the container magic
+ */
+bool isContainer(std::string_view data) {
+    return data.size() >= sizeof(containerMagic)
+        && std::memcmp(data.data(), containerMagic,
+            sizeof(containerMagic)) == 0;
+}
+
+
+/**
+ * An upper bound on the length of a container, for pre-sizing its output.
+ *
+ * @param length the number of chars of unencoded text
+ * @param blockSize the decoded size in bytes of each block. Must not be 0.
+ * @return the capacity an OutputBuffer needs to hold the container
+ */
+std::size_t containerLengthBound(std::size_t length, std::size_t blockSize) {
+    // Blocks that encoding would expand are stored raw, so no block is
+    // longer than its decoded text
+    const std::size_t numBlocks = (length + blockSize - 1) / blockSize;
+    return containerHeaderSize + length + numBlocks * containerEntrySize
+        + containerFooterSize;
+}
+
+
+/**
+ * Run-length encode a string into a block container, writing the result to
+ * the end of an OutputBuffer. Blocks are encoded on multiple threads.
+ *
+ * @param in the unencoded text to encode
+ * @param out the buffer to append the container to
+ * @param blockSize the decoded size in bytes of each block. Must not be 0.
+ * @param threads the maximum number of threads to use.
+ *                0 uses one thread per hardware thread.
+ * @throw std::invalid_argument if blockSize is 0
+ */
+void encodeContainer(std::string_view in, OutputBuffer& out,
+        std::size_t blockSize, unsigned threads) {
+    if (blockSize == 0) {
+        throw std::invalid_argument("Container block size must not be 0");
+    }
+
+    // Encode every block independently, with each thread taking the next
+    // unencoded block until none remain
+    const std::size_t numBlocks = (in.size() + blockSize - 1) / blockSize;
+    std::vector<OutputBuffer> encoded(numBlocks);
+    // Whether each block is stored raw, rather than encoded. Not a
+    // std::vector<bool>, as each block's entry is written by its own thread.
+    std::vector<char> raw(numBlocks, false);
+    std::atomic<std::size_t> nextBlock{0};
+    std::size_t numThreads = std::min<std::size_t>(
+        resolveThreadCount(threads), numBlocks);
+
+    runOnThreads(numThreads == 0 ? 1 : numThreads, [&](std::size_t) {
+        std::size_t block;
+        while ((block = nextBlock++) < numBlocks) {
+            std::string_view blockText = in.substr(block * blockSize,
+                blockSize);
+            // Store raw any block that encoding would not shrink, without
+            // encoding it if a sample of it already expands
+            if (estimateEncodedRatio(blockText) >= 1) {
+                raw[block] = true;
+                continue;
+            }
+            encode(blockText, encoded[block]);
+            if (encoded[block].size() >= blockText.size()) {
+                raw[block] = true;
+                encoded[block] = OutputBuffer{};
+            }
+        }
+    });
+
+    // Lay out the header, blocks, index and footer
+    std::size_t blocksLength{0};
+    for (std::size_t i{0}; i < numBlocks; i++) {
+        blocksLength += raw[i] ? std::min(blockSize, in.size() - i * blockSize)
+            : encoded[i].size();
+    }
+    const std::size_t indexOffset = containerHeaderSize + blocksLength;
+    const std::size_t total = indexOffset + numBlocks * containerEntrySize
+        + containerFooterSize;
+    char* dest = out.prepare(total);
+    std::memset(dest, 0, total);
+
+    std::memcpy(dest, containerMagic, sizeof(containerMagic));
+    dest[4] = static_cast<char>(containerVersion);
+    putU64(dest + 8, blockSize);
+
+    std::size_t encodedOffset = containerHeaderSize;
+    for (std::size_t i{0}; i < numBlocks; i++) {
+        std::string_view stored = raw[i] ? in.substr(i * blockSize, blockSize)
+            : encoded[i].view();
+        if (!stored.empty()) {
+            std::memcpy(dest + encodedOffset, stored.data(), stored.size());
+        }
+
+        char* entry = dest + indexOffset + i * containerEntrySize;
+        putU64(entry, encodedOffset);
+        putU64(entry + 8, stored.size());
+        putU64(entry + 16, i * blockSize);
+        putU64(entry + 24, std::min(blockSize, in.size() - i * blockSize));
+        entry[32] = static_cast<char>(raw[i] ? BlockEncoding::raw
+            : BlockEncoding::text);
+
+        encodedOffset += stored.size();
+    }
+
+    char* footer = dest + total - containerFooterSize;
+    putU64(footer, indexOffset);
+    putU64(footer + 8, numBlocks);
+    std::memcpy(footer + 16, containerMagic, sizeof(containerMagic));
+
+    out.commit(total);
+}
+
+
+/**
+ * Read and validate the header and block index of a container.
+ *
+ * @param data the whole container. Must outlive the reader.
+ * @throw std::invalid_argument if data is not a valid container
+ */
+ContainerReader::ContainerReader(std::string_view data) :
+        data(data),
+        nominalBlockSize{0},
+        totalDecodedLength{0} {
+    // Validate the header and footer
+    if (data.size() < containerHeaderSize + containerFooterSize
+            || !isContainer(data)) {
+        invalidContainer("Missing container header");
+    }
+    if (static_cast<std::uint8_t>(data[4]) != containerVersion) {
+        invalidContainer("Unsupported container version "
+            + std::to_string(static_cast<std::uint8_t>(data[4])));
+    }
+    const char* footer = data.data() + data.size() - containerFooterSize;
+    if (std::memcmp(footer + 16, containerMagic, sizeof(containerMagic))) {
+        invalidContainer("Missing container footer");
+    }
+    nominalBlockSize = getU64(data.data() + 8);
+
+    // Validate the index position
+    const std::uint64_t indexOffset = getU64(footer);
+    const std::uint64_t numBlocks = getU64(footer + 8);
+    const std::size_t indexSpace = data.size() - containerFooterSize;
+    if (indexOffset < containerHeaderSize || indexOffset > indexSpace
+            || numBlocks > (indexSpace - indexOffset) / containerEntrySize
+            || indexOffset + numBlocks * containerEntrySize != indexSpace) {
+        invalidContainer("Block index does not fit the container");
+    }
+
+    // Read and validate each index entry
+    index.reserve(numBlocks);
+    for (std::size_t i{0}; i < numBlocks; i++) {
+        const char* entry = data.data() + indexOffset + i * containerEntrySize;
+        ContainerBlock block{ getU64(entry), getU64(entry + 8),
+            getU64(entry + 16), getU64(entry + 24),
+            static_cast<BlockEncoding>(entry[32]) };
+
+        if (block.encodedOffset < containerHeaderSize
+                || block.encodedOffset > indexOffset
+                || block.encodedLength > indexOffset - block.encodedOffset) {
+            invalidContainer("Block " + std::to_string(i)
+                + " does not fit the container");
+        }
+        if (block.decodedOffset != totalDecodedLength
+                || block.decodedLength > nominalBlockSize
+                || block.decodedLength > SIZE_MAX - totalDecodedLength) {
+            invalidContainer("Block " + std::to_string(i)
+                + " is out of order");
+        }
+        if (block.encoding != BlockEncoding::text
+                && block.encoding != BlockEncoding::raw) {
+            invalidContainer("Block " + std::to_string(i)
+                + " has unknown encoding");
+        }
+        if (block.encoding == BlockEncoding::raw
+                && block.encodedLength != block.decodedLength) {
+            invalidContainer("Raw block " + std::to_string(i)
+                + " is not the length of its decoded text");
+        }
+
+        totalDecodedLength += block.decodedLength;
+        index.push_back(block);
+    }
+}
+
+
+/**
+ * @return the length in bytes of the whole decoded text
+ */
+std::size_t ContainerReader::decodedLength() const {
+    return totalDecodedLength;
+}
+
+
+/**
+ * @return the nominal decoded size in bytes of each block
+ */
+std::size_t ContainerReader::blockSize() const {
+    return nominalBlockSize;
+}
+
+
+/**
+ * @return the index of all blocks in the container, in order
+ */
+const std::vector<ContainerBlock>& ContainerReader::blocks() const {
+    return index;
+}
+
+
+/**
+ * @param blockIndex the index of the block, less than blocks().size()
+ * @return the encoded contents of the block
+ */
+std::string_view ContainerReader::blockData(std::size_t blockIndex) const {
+    const ContainerBlock& block = index.at(blockIndex);
+    return data.substr(block.encodedOffset, block.encodedLength);
+}
+
+
+/**
+ * Decode the whole container, writing the result to the end of an
+ * OutputBuffer. Blocks are decoded on multiple threads, directly into
+ * their place in the output.
+ *
+ * @param out the buffer to append the decoded text to
+ * @param threads the maximum number of threads to use.
+ *                0 uses one thread per hardware thread.
+ * @throw std::invalid_argument if a block is invalid
+ */
+void ContainerReader::decode(OutputBuffer& out, unsigned threads) const {
+    if (totalDecodedLength == 0) {
+        return;
+    }
+
+    char* dest = out.prepare(totalDecodedLength);
+    std::atomic<std::size_t> nextBlock{0};
+    std::size_t numThreads = std::min<std::size_t>(
+        resolveThreadCount(threads), index.size());
+
+    runOnThreads(numThreads, [&](std::size_t) {
+        std::size_t i;
+        while ((i = nextBlock++) < index.size()) {
+            const ContainerBlock& block = index[i];
+            if (block.encoding == BlockEncoding::raw) {
+                if (block.decodedLength != 0) {
+                    std::memcpy(dest + block.decodedOffset,
+                        blockData(i).data(), block.decodedLength);
+                }
+                continue;
+            }
+            std::size_t written = batchDecodeInto(blockData(i),
+                dest + block.decodedOffset, block.decodedLength);
+            if (written != block.decodedLength) {
+                invalidContainer("Block " + std::to_string(i)
+                    + " is shorter than its index entry");
+            }
+        }
+    });
+
+    out.commit(totalDecodedLength);
+}
+
+
+/**
+ * Decode only the given range of the decoded text, writing the result to
+ * the end of an OutputBuffer. Only the blocks overlapping the range are
+ * read.
+ *
+ * @param offset the position in the decoded text of the first char
+ * @param length the number of chars to decode
+ * @param out the buffer to append the decoded range to
+ * @throw std::out_of_range if the range extends past the decoded text
+ * @throw std::invalid_argument if a block is invalid
+ */
+void ContainerReader::decodeRange(std::size_t offset, std::size_t length,
+        OutputBuffer& out) const {
+    if (offset > totalDecodedLength
+            || length > totalDecodedLength - offset) {
+        throw std::out_of_range("Range [" + std::to_string(offset) + ", +"
+            + std::to_string(length) + ") exceeds decoded length "
+            + std::to_string(totalDecodedLength));
+    }
+    if (length == 0) {
+        return;
+    }
+
+    char* dest = out.prepare(length);
+    const std::size_t rangeEnd = offset + length;
+
+    // Decode runs from each overlapping block, skipping those before the range
+    for (std::size_t i = findBlock(offset);
+            i < index.size() && index[i].decodedOffset < rangeEnd; i++) {
+        const std::size_t blockStart = index[i].decodedOffset;
+        const std::size_t blockEnd = blockStart + index[i].decodedLength;
+        const std::size_t from = std::max(blockStart, offset);
+        const std::size_t to = std::min(blockEnd, rangeEnd);
+
+        if (index[i].encoding == BlockEncoding::raw) {
+            std::memcpy(dest + (from - offset),
+                blockData(i).data() + (from - blockStart), to - from);
+            continue;
+        }
+        EncodedRunReader reader{ blockData(i) };
+        std::size_t reached = decodeRunsInRange(reader, blockStart, from,
+            to - from, dest + (from - offset));
+
+        if (reached > blockEnd) {
+            invalidContainer("Block " + std::to_string(i)
+                + " is longer than its index entry");
+        } else if (reached < to) {
+            invalidContainer("Block " + std::to_string(i)
+                + " is shorter than its index entry");
+        }
+    }
+
+    out.commit(length);
+}
+
+
+/**
+ * @param offset a position in the decoded text, less than decodedLength()
+ * @return the index of the block containing that position
+ */
+std::size_t ContainerReader::findBlock(std::size_t offset) const {
+    // Find the first block starting after offset, then step back one
+    auto after = std::upper_bound(index.begin(), index.end(), offset,
+        [](std::size_t value, const ContainerBlock& block) {
+            return value < block.decodedOffset;
+        });
+    return (after - index.begin()) - 1;
+}
@@ -0,0 +1,196 @@
+/**
+ * Seekable block container format for jRLE.
+ *
+ * Plain encoded text must be decoded from its start, one token at a time.
+ * The container instead splits the unencoded text into fixed-size blocks,
+ * and run-length encodes each block independently. An index of the blocks
+ * follows them, so blocks can be decoded in parallel, and any range of the
+ * decoded text can be decoded without touching the rest.
+ *
+ *                  == Container Layout ==
+ * All integers are unsigned and little-endian.
+ * - Header (16 bytes):
+ *   + "JRLB" magic
+ *   + u8 format version, currently 1
+ *   + 3 reserved bytes, set to 0
+ *   + u64 nominal decoded size of each block
+ * - Blocks: the encoded text of each block, in order
+ * - Index: one 40-byte entry per block, in order:
+ *   + u64 offset of the block's encoded text within the container
+ *   + u64 length of the block's encoded text
+ *   + u64 offset of the block's decoded text within the decoded text
+ *   + u64 length of the block's decoded text
+ *   + u8 block encoding. 0 is jRLE text, as produced by encode(). 1 is
+ *     raw: the block's decoded text, stored as is.
+ *   + 7 reserved bytes, set to 0
+ * - Footer (24 bytes):
+ *   + u64 offset of the index within the container
+ *   + u64 number of blocks
+ *   + "JRLB" magic
+ *   + 4 reserved bytes, set to 0
+ *
+ * Blocks that run-length encoding would expand, such as high-entropy data,
+ * are stored raw instead. Each block's encoded length is first estimated
+ * from samples of it with estimateEncodedRatio(), so a block estimated to
+ * expand is never encoded at all. Otherwise the block is encoded, and only
+ * kept if it is shorter than the block itself.
+ *
+ * The plain text format remains the default everywhere. Encoded text
+ * always starts with a digit or '#', so can never be mistaken for a
+ * container.
+ *
+ * For example, to encode into and decode from a container:
+ * OutputBuffer container;
+ * encodeContainer(text, container);
+ * OutputBuffer decoded;
+ * ContainerReader{ container.view() }.decode(decoded);
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_CONTAINER_H
+#define JRLE_CONTAINER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "jRLECodec.h"
+
+
+/**
+ * The default decoded size in bytes of each block in a container
+ */
+constexpr std::size_t defaultContainerBlockSize = 1 << 20;
+
+
+/**
+ * The encodings that a container block may be stored in
+ */
+enum class BlockEncoding : std::uint8_t {
+    // jRLE text, as produced by encode()
+    text = 0,
+    // The decoded text, stored as is
+    raw = 1
+};
+
+
+/**
+ * A single entry in a container's block index
+ */
+struct ContainerBlock {
+    std::uint64_t encodedOffset;
+    std::uint64_t encodedLength;
+    std::uint64_t decodedOffset;
+    std::uint64_t decodedLength;
+    BlockEncoding encoding;
+};
+
+
+/**
+ * Check whether data begins like a container, rather than like encoded text.
+ *
+ * @param data the data to check
+ * @return true if data starts with the container magic
+ */
+bool isContainer(std::string_view data);
+
+
+/**
+ * An upper bound on the length of a container, for pre-sizing its output.
+ *
+ * @param length the number of chars of unencoded text
+ * @param blockSize the decoded size in bytes of each block. Must not be 0.
+ * @return the capacity an OutputBuffer needs to hold the container
+ */
+std::size_t containerLengthBound(std::size_t length,
+    std::size_t blockSize = defaultContainerBlockSize);
+
+
+/**
+ * Run-length encode a string into a block container, writing the result to
+ * the end of an OutputBuffer. Blocks are encoded on multiple threads.
+ *
+ * @param in the unencoded text to encode
+ * @param out the buffer to append the container to
+ * @param blockSize the decoded size in bytes of each block. Must not be 0.
+ * @param threads the maximum number of threads to use.
+ *                0 uses one thread per hardware thread.
+ * @throw std::invalid_argument if blockSize is 0
+ */
+void encodeContainer(std::string_view in, OutputBuffer& out,
+    std::size_t blockSize = defaultContainerBlockSize, unsigned threads = 0);
+
+
+/**
+ * Provides decoding access to a block container, held in memory.
+ */
+class ContainerReader {
+public:
+    /**
+     * Read and validate the header and block index of a container.
+     *
+     * @param data the whole container. Must outlive the reader.
+     * @throw std::invalid_argument if data is not a valid container
+     */
+    explicit ContainerReader(std::string_view data);
+
+    /**
+     * @return the length in bytes of the whole decoded text
+     */
+    std::size_t decodedLength() const;
+
+    /**
+     * @return the nominal decoded size in bytes of each block
+     */
+    std::size_t blockSize() const;
+
+    /**
+     * @return the index of all blocks in the container, in order
+     */
+    const std::vector<ContainerBlock>& blocks() const;
+
+    /**
+     * @param blockIndex the index of the block, less than blocks().size()
+     * @return the encoded contents of the block
+     */
+    std::string_view blockData(std::size_t blockIndex) const;
+
+    /**
+     * Decode the whole container, writing the result to the end of an
+     * OutputBuffer. Blocks are decoded on multiple threads, directly into
+     * their place in the output, with the batch decoder from jRLEBatch.h.
+     *
+     * @param out the buffer to append the decoded text to
+     * @param threads the maximum number of threads to use.
+     *                0 uses one thread per hardware thread.
+     * @throw std::invalid_argument if a block is invalid
+     */
+    void decode(OutputBuffer& out, unsigned threads = 0) const;
+
+    /**
+     * Decode only the given range of the decoded text, writing the result to
+     * the end of an OutputBuffer. Only the blocks overlapping the range are
+     * read.
+     *
+     * @param offset the position in the decoded text of the first char
+     * @param length the number of chars to decode
+     * @param out the buffer to append the decoded range to
+     * @throw std::out_of_range if the range extends past the decoded text
+     * @throw std::invalid_argument if a block is invalid
+     */
+    void decodeRange(std::size_t offset, std::size_t length,
+        OutputBuffer& out) const;
+
+private:
+    std::size_t findBlock(std::size_t offset) const;
+
+    std::string_view data;
+    std::size_t nominalBlockSize;
+    std::size_t totalDecodedLength;
+    std::vector<ContainerBlock> index;
+};
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * Reusable en/decoder contexts for jRLE.
+ * See jRLEContext.h for usage.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLEContext.h"
+#include "jRLEPolicy.h"
+
+
+/**
+ * Run-length encode text in a single pass.
+ *
+ * @param in pointer to the unencoded text
+ * @param length the number of chars of unencoded text
+ * @param out pointer to space for the encoded text
+ * @param capacity the number of chars available at out.
+ *                 maxEncodedLength(length) is always enough.
+ * @return the number of chars written to out. If status() is then
+ *         outputTooSmall, every eToken that fit was written, and the
+ *         error position is that of the first run in the text that
+ *         did not.
+ */
+std::size_t Encoder::encode(const char* in, std::size_t length, char* out,
+        std::size_t capacity) {
+    lastError = CodecError{};
+    return DefaultRLE::encodeInto({ in, length }, out, capacity, false,
+        lastError);
+}
+
+
+/**
+ * Calculate the exact length of text once run-length encoded, without
+ * encoding it. Always succeeds.
+ *
+ * @param in pointer to the unencoded text
+ * @param length the number of chars of unencoded text
+ * @return the number of chars encode() would write
+ */
+std::size_t Encoder::encodedLength(const char* in, std::size_t length) {
+    lastError = CodecError{};
+    return DefaultRLE::encodedLength({ in, length });
+}
+
+
+/**
+ * Run-length decode text in a single pass.
+ *
+ * @param in pointer to the encoded text
+ * @param length the number of chars of encoded text
+ * @param out pointer to space for the decoded text
+ * @param capacity the number of chars available at out
+ * @return the number of chars written to out. If status() is then
+ *         invalidEncoding or outputTooSmall, every run before the error
+ *         was written.
+ */
+std::size_t Decoder::decode(const char* in, std::size_t length, char* out,
+        std::size_t capacity) {
+    lastError = CodecError{};
+    return DefaultRLE::decodeInto({ in, length }, out, capacity, lastError);
+}
+
+
+/**
+ * Calculate the exact length of run-length encoded text once decoded,
+ * without decoding it, and so check that it is valid.
+ *
+ * @param in pointer to the encoded text
+ * @param length the number of chars of encoded text
+ * @return the number of chars decode() would write, or 0 if status() is
+ *         then invalidEncoding
+ */
+std::size_t Decoder::decodedLength(const char* in, std::size_t length) {
+    lastError = CodecError{};
+    return DefaultRLE::decodedLength({ in, length }, lastError);
+}
+
+
+/**
+ * Check whether run-length encoded text is valid, without decoding it.
+ * Much faster than decoding or measuring the text, for rejecting
+ * untrusted text early.
+ *
+ * @param in pointer to the encoded text
+ * @param length the number of chars of encoded text
+ * @return true if the encoded text is valid. If not, status() is then
+ *         invalidEncoding.
+ */
+bool Decoder::validate(const char* in, std::size_t length) {
+    lastError = CodecError{};
+    return DefaultRLE::validate({ in, length }, lastError);
+}
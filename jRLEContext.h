@@ -0,0 +1,156 @@
+/**
+ * Reusable en/decoder contexts for jRLE, for embedding in services.
+ *
+ * An Encoder or Decoder en/decodes between spans of chars owned by the
+ * caller. It never allocates and never throws: a failed call reports its
+ * status as a CodecStatus, and the context keeps a description of the error
+ * until its next call. A context holds nothing but that error, so is cheap
+ * to keep one of per thread, and calls on different contexts never contend.
+ *
+ * Decoding into a span of fixed capacity also limits how much untrusted
+ * encoded text may expand to: text decoding to more than the capacity is
+ * rejected once the capacity is reached, without decoding the rest.
+ *
+ * For example, to encode a request into a buffer kept between requests:
+ * Encoder encoder;
+ * std::size_t length = encoder.encode(request.data(), request.size(),
+ *     buffer.data(), buffer.size());
+ * if (encoder.status() != CodecStatus::ok) {
+ *     log(encoder.error().reason, encoder.error().position);
+ * }
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_CONTEXT_H
+#define JRLE_CONTEXT_H
+
+#include <cstddef>
+
+#include "jRLECodec.h"
+
+
+/**
+ * Run-length encodes text into caller-supplied spans of chars, without
+ * allocating or throwing.
+ */
+class Encoder {
+public:
+    /**
+     * The capacity always enough to encode text, without measuring it.
+     *
+     * @param length the number of chars of unencoded text
+     * @return the capacity encode() needs for the text
+     */
+    static constexpr std::size_t maxEncodedLength(std::size_t length) {
+        return encodedLengthBound(length);
+    }
+
+    /**
+     * Run-length encode text in a single pass.
+     *
+     * @param in pointer to the unencoded text
+     * @param length the number of chars of unencoded text
+     * @param out pointer to space for the encoded text
+     * @param capacity the number of chars available at out.
+     *                 maxEncodedLength(length) is always enough.
+     * @return the number of chars written to out. If status() is then
+     *         outputTooSmall, every eToken that fit was written, and the
+     *         error position is that of the first run in the text that
+     *         did not.
+     */
+    std::size_t encode(const char* in, std::size_t length, char* out,
+        std::size_t capacity);
+
+    /**
+     * Calculate the exact length of text once run-length encoded, without
+     * encoding it. Always succeeds.
+     *
+     * @param in pointer to the unencoded text
+     * @param length the number of chars of unencoded text
+     * @return the number of chars encode() would write
+     */
+    std::size_t encodedLength(const char* in, std::size_t length);
+
+    /**
+     * @return the outcome of the last call
+     */
+    CodecStatus status() const {
+        return lastError.status;
+    }
+
+    /**
+     * @return a description of the error in the last call, if it failed
+     */
+    const CodecError& error() const {
+        return lastError;
+    }
+
+private:
+    CodecError lastError;
+};
+
+
+/**
+ * Run-length decodes text into caller-supplied spans of chars, without
+ * allocating or throwing.
+ */
+class Decoder {
+public:
+    /**
+     * Run-length decode text in a single pass.
+     *
+     * @param in pointer to the encoded text
+     * @param length the number of chars of encoded text
+     * @param out pointer to space for the decoded text
+     * @param capacity the number of chars available at out
+     * @return the number of chars written to out. If status() is then
+     *         invalidEncoding or outputTooSmall, every run before the error
+     *         was written.
+     */
+    std::size_t decode(const char* in, std::size_t length, char* out,
+        std::size_t capacity);
+
+    /**
+     * Calculate the exact length of run-length encoded text once decoded,
+     * without decoding it, and so check that it is valid.
+     *
+     * @param in pointer to the encoded text
+     * @param length the number of chars of encoded text
+     * @return the number of chars decode() would write, or 0 if status() is
+     *         then invalidEncoding
+     */
+    std::size_t decodedLength(const char* in, std::size_t length);
+
+    /**
+     * Check whether run-length encoded text is valid, without decoding it.
+     * Much faster than decoding or measuring the text, for rejecting
+     * untrusted text early.
+     *
+     * @param in pointer to the encoded text
+     * @param length the number of chars of encoded text
+     * @return true if the encoded text is valid. If not, status() is then
+     *         invalidEncoding.
+     */
+    bool validate(const char* in, std::size_t length);
+
+    /**
+     * @return the outcome of the last call
+     */
+    CodecStatus status() const {
+        return lastError.status;
+    }
+
+    /**
+     * @return a description of the error in the last call, if it failed
+     */
+    const CodecError& error() const {
+        return lastError;
+    }
+
+private:
+    CodecError lastError;
+};
+
+#endif
@@ -0,0 +1,309 @@
+/**
+ * Hybrid literal/run text encoding for jRLE.
+ * See jRLEHybrid.h for usage, and for the hybrid layout.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLEHybrid.h"
+#include "jRLEScan.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+constexpr char hybridMagic[4] = { 'J', 'R', 'L', 'H' };
+
+constexpr char literalKind = ':';
+constexpr char runKind = '*';
+
+// The longest possible token header: a 20-digit length, and its kind
+constexpr std::size_t maxHybridHeaderLength = 21;
+
+
+/**
+ * Throw an exception describing invalid hybrid encoded text.
+ *
+ * @param reason description of the error
+ * @param position the position in the encoded text of the error
+ * @throw std::invalid_argument always
+ */
+[[noreturn]] static void invalidHybrid(const char* reason,
+        std::size_t position) {
+    throw std::invalid_argument(std::string("Invalid hybrid encoding. ")
+        + reason + " at position " + std::to_string(position));
+}
+
+
+/**
+ * @param value the value to measure
+ * @return the number of decimal digits in value
+ */
+static std::size_t decimalLength(std::size_t value) {
+    std::size_t length{1};
+    while (value >= 10) {
+        value /= 10;
+        length++;
+    }
+    return length;
+}
+
+
+/**
+ * Write a token header.
+ *
+ * @param out pointer to space for maxHybridHeaderLength chars
+ * @param length the decoded length of the token
+ * @param kind the kind of the token
+ * @return the number of chars written
+ */
+static std::size_t writeHeader(char* out, std::size_t length, char kind) {
+    char* end = std::to_chars(out, out + maxHybridHeaderLength - 1,
+        length).ptr;
+    *end++ = kind;
+    return end - out;
+}
+
+
+/**
+ * Read a token header from hybrid encoded text.
+ *
+ * @param in the encoded text
+ * @param pos the position of the header, advanced past it
+ * @param literal set to whether the token is a literal, rather than a run
+ * @return the length of the token's decoded text
+ * @throw std::invalid_argument if the header is invalid
+ */
+static std::size_t readHeader(std::string_view in, std::size_t& pos,
+        bool& literal) {
+    const std::size_t start = pos;
+    std::size_t length{0};
+
+    while (pos < in.size() && in[pos] >= '0' && in[pos] <= '9') {
+        const std::size_t digit = in[pos] - '0';
+        if (length > (SIZE_MAX - digit) / 10) {
+            invalidHybrid("Token too long", start);
+        }
+        length = length * 10 + digit;
+        pos++;
+    }
+
+    if (pos == start) {
+        invalidHybrid("Missing token length", start);
+    } else if (pos == in.size()) {
+        invalidHybrid("Truncated token header", start);
+    } else if (length == 0) {
+        invalidHybrid("Empty token", start);
+    }
+    if (in[pos] == literalKind) {
+        literal = true;
+    } else if (in[pos] == runKind) {
+        literal = false;
+    } else {
+        invalidHybrid("Unknown token kind", pos);
+    }
+    pos++;
+    return length;
+}
+
+
+/**
+ * Check and skip the magic at the start of hybrid encoded text.
+ *
+ * @param in the encoded text
+ * @return the position of the first token
+ * @throw std::invalid_argument if the magic is missing
+ */
+static std::size_t skipMagic(std::string_view in) {
+    if (!isHybridEncoded(in)) {
+        invalidHybrid("Missing hybrid format magic", 0);
+    }
+    return sizeof(hybridMagic);
+}
+
+
+/**
+ * Check whether data begins like hybrid encoded text.
+ *
+ * @param data the data to check
+ * @return true if data starts with the hybrid format magic
+ */
+bool isHybridEncoded(std::string_view data) {
+    return data.size() >= sizeof(hybridMagic)
+        && std::memcmp(data.data(), hybridMagic, sizeof(hybridMagic)) == 0;
+}
+
+
+/**
+ * Write a literal token.
+ *
+ * @param begin pointer to the first char of the literal
+ * @param end pointer to the char after the literal
+ * @param out the buffer to append the token to
+ */
+static void writeLiteral(const char* begin, const char* end,
+        OutputBuffer& out) {
+    const std::size_t length = end - begin;
+    if (length == 0) {
+        return;
+    }
+    char* token = out.prepare(maxHybridHeaderLength + length);
+    std::size_t headerLength = writeHeader(token, length, literalKind);
+    std::memcpy(token + headerLength, begin, length);
+    out.commit(headerLength + length);
+}
+
+
+/**
+ * Run-length encode text into the hybrid format, writing the result to the
+ * end of an OutputBuffer.
+ *
+ * @param in the unencoded text to encode
+ * @param out the buffer to append the encoded text to
+ */
+void encodeHybrid(std::string_view in, OutputBuffer& out) {
+    out.append(std::string_view(hybridMagic, sizeof(hybridMagic)));
+
+    const char* begin = in.data();
+    const char* end = begin + in.size();
+
+    // Find every run long enough that a run token could be shorter than it,
+    // even with a literal header after it
+    std::vector<std::pair<std::size_t, std::size_t>> runs;
+    for (const char* pos = begin; pos < end; ) {
+        const char* runEnd = findRunEnd(pos, end);
+        if (runEnd - pos > 4 || (runEnd == end && runEnd - pos > 2)) {
+            runs.emplace_back(pos - begin, runEnd - pos);
+        }
+        pos = runEnd;
+    }
+
+    // A run token splits the literal around it, so must pay for the header
+    // of the literal after it as well as for itself. That literal depends
+    // on which later runs are tokens, so decide from the last run back.
+    // Kept runs are moved to the back, which is already decided.
+    std::size_t nextTokenStart = in.size();
+    std::size_t firstKept = runs.size();
+    for (std::size_t i = runs.size(); i-- > 0; ) {
+        const std::size_t runEnd = runs[i].first + runs[i].second;
+        const std::size_t literalLength = nextTokenStart - runEnd;
+        const std::size_t cost = decimalLength(runs[i].second) + 2
+            + (literalLength == 0 ? 0 : decimalLength(literalLength) + 1);
+        if (cost < runs[i].second) {
+            nextTokenStart = runs[i].first;
+            runs[--firstKept] = runs[i];
+        }
+    }
+
+    // Write the runs kept, and the literals between them
+    const char* literalStart = begin;
+    for (std::size_t i = firstKept; i < runs.size(); i++) {
+        writeLiteral(literalStart, begin + runs[i].first, out);
+
+        char* token = out.prepare(maxHybridHeaderLength + 1);
+        std::size_t headerLength = writeHeader(token, runs[i].second,
+            runKind);
+        token[headerLength] = begin[runs[i].first];
+        out.commit(headerLength + 1);
+
+        literalStart = begin + runs[i].first + runs[i].second;
+    }
+    writeLiteral(literalStart, end, out);
+}
+
+
+/**
+ * Calculate the exact length of hybrid encoded text once decoded, without
+ * decoding it. Literals are skipped over without being read.
+ *
+ * @param in the encoded text to measure
+ * @return the number of chars in the decoded text
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+std::size_t hybridDecodedLength(std::string_view in) {
+    std::size_t pos = skipMagic(in);
+    std::size_t total{0};
+    bool literal;
+
+    while (pos < in.size()) {
+        const std::size_t start = pos;
+        std::size_t length = readHeader(in, pos, literal);
+        std::size_t encodedLength = literal ? length : 1;
+        if (encodedLength > in.size() - pos) {
+            invalidHybrid("Truncated token", start);
+        }
+        if (length > SIZE_MAX - total) {
+            invalidHybrid("Decoded length too large", start);
+        }
+        pos += encodedLength;
+        total += length;
+    }
+
+    return total;
+}
+
+
+/**
+ * Run-length decode hybrid encoded text, writing the result to the end of
+ * an OutputBuffer. Space for the whole result is made exactly once.
+ *
+ * @param in the encoded text to decode
+ * @param out the buffer to append the decoded text to. If the encoded text
+ *            is invalid, the buffer is left unchanged.
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+void decodeHybrid(std::string_view in, OutputBuffer& out) {
+    const std::size_t length = hybridDecodedLength(in);
+    if (length == 0) {
+        return;
+    }
+    out.commit(decodeHybridInto(in, out.prepare(length), length));
+}
+
+
+/**
+ * Run-length decode hybrid encoded text into a caller-supplied span of chars.
+ *
+ * @param in the encoded text to decode
+ * @param out pointer to space for the decoded text
+ * @param capacity the number of chars available at out
+ * @return the number of chars written to out
+ * @throw std::invalid_argument if the encoded text is invalid, or decodes
+ *        to more than capacity chars
+ */
+std::size_t decodeHybridInto(std::string_view in, char* out,
+        std::size_t capacity) {
+    std::size_t pos = skipMagic(in);
+    std::size_t written{0};
+    bool literal;
+
+    while (pos < in.size()) {
+        const std::size_t start = pos;
+        std::size_t length = readHeader(in, pos, literal);
+        if (length > capacity - written) {
+            invalidHybrid("Decoded text too long", start);
+        }
+
+        if (literal) {
+            if (length > in.size() - pos) {
+                invalidHybrid("Truncated token", start);
+            }
+            std::memcpy(out + written, in.data() + pos, length);
+            pos += length;
+        } else {
+            if (pos == in.size()) {
+                invalidHybrid("Truncated token", start);
+            }
+            std::memset(out + written, in[pos], length);
+            pos++;
+        }
+        written += length;
+    }
+
+    return written;
+}
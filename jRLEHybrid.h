@@ -0,0 +1,114 @@
+/**
+ * Hybrid literal/run text encoding for jRLE.
+ *
+ * The text format writes a count for every run, so text made mostly of
+ * single chars roughly doubles in size, and decoding it means reading a
+ * count and writing a run for every char. The hybrid format instead groups
+ * stretches of short runs into literals, stored as they are behind a
+ * decimal length, and only writes long runs as a count and a char.
+ * Decoding a literal is then a single copy.
+ *
+ *                  == Hybrid Layout ==
+ * - "JRLH" magic
+ * - Tokens, in order. Each token starts with its decoded length in decimal
+ *   digits, which must not be 0, followed by its kind:
+ *   + ':' (literal): followed by length chars, copied as they are
+ *   + '*' (run): followed by a single char, repeated length times
+ *
+ * For example, "hello" followed by 12 'a' chars and "!" is encoded as
+ * "JRLH5:hello12*a1:!".
+ *
+ * A run is written as a run token only when that is no longer than leaving
+ * it in the literal, counting the header of the literal that must follow
+ * it. Encoded text is therefore never more than hybridEncodedLengthBound()
+ * chars, barely longer than the text itself.
+ *
+ * For example, to encode and decode a string:
+ * OutputBuffer encoded;
+ * encodeHybrid(text, encoded);
+ * OutputBuffer decoded;
+ * decodeHybrid(encoded.view(), decoded);
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_HYBRID_H
+#define JRLE_HYBRID_H
+
+#include <cstddef>
+#include <string_view>
+
+#include "jRLECodec.h"
+
+
+/**
+ * An upper bound on the length of hybrid encoded text.
+ *
+ * @param length the number of chars of unencoded text
+ * @return the capacity an OutputBuffer needs to encode the text
+ */
+constexpr std::size_t hybridEncodedLengthBound(std::size_t length) {
+    // Every run token pays for itself and the literal header after it, so
+    // only the magic and the header of the first literal are extra: at most
+    // 20 digits and a ':'
+    return length + 4 + 21;
+}
+
+
+/**
+ * Check whether data begins like hybrid encoded text.
+ *
+ * @param data the data to check
+ * @return true if data starts with the hybrid format magic
+ */
+bool isHybridEncoded(std::string_view data);
+
+
+/**
+ * Run-length encode text into the hybrid format, writing the result to the
+ * end of an OutputBuffer.
+ *
+ * @param in the unencoded text to encode
+ * @param out the buffer to append the encoded text to
+ */
+void encodeHybrid(std::string_view in, OutputBuffer& out);
+
+
+/**
+ * Calculate the exact length of hybrid encoded text once decoded, without
+ * decoding it. Literals are skipped over without being read.
+ *
+ * @param in the encoded text to measure
+ * @return the number of chars in the decoded text
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+std::size_t hybridDecodedLength(std::string_view in);
+
+
+/**
+ * Run-length decode hybrid encoded text, writing the result to the end of
+ * an OutputBuffer. Space for the whole result is made exactly once.
+ *
+ * @param in the encoded text to decode
+ * @param out the buffer to append the decoded text to. If the encoded text
+ *            is invalid, the buffer is left unchanged.
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+void decodeHybrid(std::string_view in, OutputBuffer& out);
+
+
+/**
+ * Run-length decode hybrid encoded text into a caller-supplied span of chars.
+ *
+ * @param in the encoded text to decode
+ * @param out pointer to space for the decoded text
+ * @param capacity the number of chars available at out
+ * @return the number of chars written to out
+ * @throw std::invalid_argument if the encoded text is invalid, or decodes
+ *        to more than capacity chars
+ */
+std::size_t decodeHybridInto(std::string_view in, char* out,
+    std::size_t capacity);
+
+#endif
@@ -0,0 +1,643 @@
+/**
+ * Memory-mapped file input and output for jRLE.
+ * See jRLEIO.h for usage.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLEIO.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <ios>
+#include <iostream>
+#include <system_error>
+
+#if JRLE_HAVE_MMAP
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+
+// The number of bytes to read or write at a time, when not mapping a file
+constexpr std::size_t fileBufferSize = 1 << 16;
+
+
+/**
+ * Throw an exception describing a file that could not be opened.
+ *
+ * @param fname path to the file
+ * @throw std::ios_base::failure always
+ */
+[[noreturn]] static void openError(const std::string& fname) {
+    throw std::ios_base::failure("Error opening file '" + fname
+        + "' - Ensure path is correct and file is not in use.");
+}
+
+
+#if JRLE_HAVE_MMAP
+/**
+ * Read the entire remaining contents of a file descriptor into a string.
+ *
+ * @param fd the open file descriptor to read
+ * @param fname path to the file, for error messages
+ * @return std::string containing the exact bytes read
+ * @throw std::ios_base::failure if the file could not be read
+ */
+static std::string readAll(int fd, const std::string& fname) {
+    std::string contents;
+    std::size_t length{0};
+    while (true) {
+        contents.resize(length + fileBufferSize);
+        ssize_t count = ::read(fd, &contents[length], fileBufferSize);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count < 0) {
+            contents.clear();
+            throw std::ios_base::failure("Error reading file '" + fname
+                + "'");
+        } else if (count == 0) {
+            break;
+        }
+        length += static_cast<std::size_t>(count);
+    }
+    contents.resize(length);
+    return contents;
+}
+
+
+/**
+ * Write the whole of a span of bytes to a file descriptor.
+ *
+ * @param fd the open file descriptor to write to
+ * @param data pointer to the bytes to write
+ * @param length the number of bytes to write
+ * @return true if every byte was written
+ */
+static bool writeAll(int fd, const char* data, std::size_t length) {
+    while (length != 0) {
+        std::size_t chunk = length < fileBufferSize ? length : fileBufferSize;
+        ssize_t count = ::write(fd, data, chunk);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count <= 0) {
+            return false;
+        }
+        data += count;
+        length -= static_cast<std::size_t>(count);
+    }
+    return true;
+}
+
+
+/**
+ * Allocate disk space for the start of a file, extending the file if it is
+ * shorter, so that writing to it through a mapping cannot run out of space.
+ *
+ * @param fd the open file descriptor of the file
+ * @param length the number of bytes to allocate space for
+ * @return true if the space was allocated, or false if there is not enough,
+ *         or it cannot be allocated on this platform or file system
+ */
+static bool reserveSpace(int fd, std::size_t length) {
+#if defined(__linux__)
+    // Unlike posix_fallocate(), never falls back to writing every block
+    int result;
+    do {
+        result = ::fallocate(fd, 0, 0, static_cast<off_t>(length));
+    } while (result != 0 && errno == EINTR);
+    return result == 0;
+#elif defined(__APPLE__)
+    static_cast<void>(fd);
+    static_cast<void>(length);
+    return false;
+#else
+    return ::posix_fallocate(fd, 0, static_cast<off_t>(length)) == 0;
+#endif
+}
+#endif
+
+
+/**
+ * Open and map a file. The file must not be modified while it is open.
+ *
+ * @param fname path to the file to read
+ * @throw std::ios_base::failure if the file could not be opened or read
+ */
+MappedInputFile::MappedInputFile(const std::string& fname) {
+#if JRLE_HAVE_MMAP
+    int fd = ::open(fname.c_str(), O_RDONLY);
+    if (fd < 0) {
+        openError(fname);
+    }
+
+    // Only regular files with a known length can be mapped. Some files,
+    // such as those in /proc, report a length of 0 despite having contents.
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)
+            && info.st_size > 0) {
+        mappedLength = static_cast<std::size_t>(info.st_size);
+        void* addr = ::mmap(nullptr, mappedLength, PROT_READ, MAP_PRIVATE,
+            fd, 0);
+        if (addr != MAP_FAILED) {
+            // En/decoding reads the file once from start to end, so let the
+            // kernel read ahead aggressively
+            ::madvise(addr, mappedLength, MADV_SEQUENTIAL);
+            mapping = addr;
+            ::close(fd);
+            return;
+        }
+        mappedLength = 0;
+    }
+
+    // Fall back to reading the whole file
+    try {
+        contents = readAll(fd, fname);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+#else
+    std::ifstream freader{ fname, std::ios::binary };
+    if (!freader) {
+        openError(fname);
+    }
+    char chunk[fileBufferSize];
+    while (freader.read(chunk, sizeof(chunk)) || freader.gcount() > 0) {
+        contents.append(chunk, static_cast<std::size_t>(freader.gcount()));
+    }
+    if (freader.bad()) {
+        throw std::ios_base::failure("Error reading file '" + fname + "'");
+    }
+#endif
+}
+
+
+MappedInputFile::~MappedInputFile() {
+    close();
+}
+
+
+/**
+ * @return the contents of the file. Valid until the file is closed.
+ */
+std::string_view MappedInputFile::view() const {
+    if (mapping != nullptr) {
+        return { static_cast<const char*>(mapping), mappedLength };
+    }
+    return contents;
+}
+
+
+/**
+ * @return true if the file is memory-mapped, rather than read into memory
+ */
+bool MappedInputFile::isMapped() const {
+    return mapping != nullptr;
+}
+
+
+/**
+ * Unmap the file, invalidating view().
+ */
+void MappedInputFile::close() {
+#if JRLE_HAVE_MMAP
+    if (mapping != nullptr) {
+        ::munmap(mapping, mappedLength);
+    }
+#endif
+    mapping = nullptr;
+    mappedLength = 0;
+    contents.clear();
+    contents.shrink_to_fit();
+}
+
+
+/**
+ * Create or truncate a file, and make space to write into it.
+ *
+ * @param fname path to the file to write
+ * @param capacity the maximum number of bytes that will be written. The
+ *                 buffer cannot grow beyond this if the file is mapped.
+ * @throw std::ios_base::failure if the file could not be opened
+ */
+MappedOutputFile::MappedOutputFile(const std::string& fname,
+        std::size_t capacity) :
+        name(fname) {
+#if JRLE_HAVE_MMAP
+    fd = ::open(fname.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        openError(fname);
+    }
+
+    // Extend the file to its maximum length, allocating its space first so
+    // that writing through the mapping cannot fail. Any space not written
+    // is freed when the file is truncated on commit.
+    if (capacity != 0 && reserveSpace(fd, capacity)) {
+        void* addr = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+        if (addr != MAP_FAILED) {
+            ::madvise(addr, capacity, MADV_SEQUENTIAL);
+            mapping = addr;
+            mappedLength = capacity;
+            out = OutputBuffer{ static_cast<char*>(addr), capacity };
+            return;
+        }
+    }
+#else
+    // Create the file now, so that errors are reported before en/decoding
+    std::ofstream fwriter{ fname, std::ios::binary };
+    if (!fwriter) {
+        openError(fname);
+    }
+#endif
+
+    // Fall back to buffering the whole file, to be written on commit
+    out.reserve(capacity);
+}
+
+
+MappedOutputFile::~MappedOutputFile() {
+#if JRLE_HAVE_MMAP
+    if (mapping != nullptr) {
+        ::munmap(mapping, mappedLength);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+#endif
+}
+
+
+/**
+ * @return the buffer to write the file's contents into
+ */
+OutputBuffer& MappedOutputFile::buffer() {
+    return out;
+}
+
+
+/**
+ * @return true if the file is memory-mapped, rather than buffered
+ */
+bool MappedOutputFile::isMapped() const {
+    return mapping != nullptr;
+}
+
+
+/**
+ * Finish writing the file, truncating it to the length of the buffer.
+ * The buffer must not be used afterwards.
+ *
+ * @param sync whether to flush the file to disk before returning, where
+ *             supported
+ * @throw std::ios_base::failure if the file could not be written
+ */
+void MappedOutputFile::commit(bool sync) {
+#if JRLE_HAVE_MMAP
+    bool written;
+    if (mapping != nullptr) {
+        written = ::munmap(mapping, mappedLength) == 0;
+        mapping = nullptr;
+        written = ::ftruncate(fd, static_cast<off_t>(out.size())) == 0
+            && written;
+    } else {
+        written = writeAll(fd, out.data(), out.size())
+            && ::ftruncate(fd, static_cast<off_t>(out.size())) == 0;
+    }
+    // Unmapping does not write back the mapped pages, but syncing does
+    if (sync) {
+        written = ::fsync(fd) == 0 && written;
+    }
+    written = ::close(fd) == 0 && written;
+    fd = -1;
+#else
+    static_cast<void>(sync);
+    std::ofstream fwriter{ name, std::ios::binary };
+    fwriter.write(out.data(), out.size());
+    fwriter.close();
+    bool written = static_cast<bool>(fwriter);
+#endif
+    out = OutputBuffer{};
+
+    if (!written) {
+        throw std::ios_base::failure("Error writing file '" + name + "'");
+    }
+}
+
+
+/**
+ * Create or truncate a file, and write the whole of a span of bytes to it
+ * with plain writes. For small files, this costs fewer system calls than
+ * mapping them with a MappedOutputFile.
+ *
+ * @param fname path to the file to write
+ * @param contents the bytes to write
+ * @param sync whether to flush the file to disk before returning, where
+ *             supported
+ * @throw std::ios_base::failure if the file could not be opened or written
+ */
+void writeWholeFile(const std::string& fname, std::string_view contents,
+        bool sync) {
+#if JRLE_HAVE_MMAP
+    int fd = ::open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        openError(fname);
+    }
+    bool written = writeAll(fd, contents.data(), contents.size());
+    if (sync) {
+        written = ::fsync(fd) == 0 && written;
+    }
+    written = ::close(fd) == 0 && written;
+#else
+    static_cast<void>(sync);
+    std::ofstream fwriter{ fname, std::ios::binary };
+    if (!fwriter) {
+        openError(fname);
+    }
+    fwriter.write(contents.data(), contents.size());
+    fwriter.close();
+    bool written = static_cast<bool>(fwriter);
+#endif
+
+    if (!written) {
+        throw std::ios_base::failure("Error writing file '" + fname + "'");
+    }
+}
+
+
+/**
+ * Write a span of bytes into a file at an offset, creating the file if it
+ * does not exist, and discard anything in the file after them. The file is
+ * changed in place, so unlike replaceFile(), a crash may leave it partly
+ * written.
+ *
+ * @param fname path to the file to write
+ * @param offset the position in the file to write the bytes at. Must be no
+ *               greater than the length of the file.
+ * @param contents the bytes to write
+ * @param sync whether to flush the file to disk before returning, where
+ *             supported
+ * @throw std::ios_base::failure if the file could not be opened or written
+ */
+void writeFileAt(const std::string& fname, std::size_t offset,
+        std::string_view contents, bool sync) {
+    const std::size_t end = offset + contents.size();
+#if JRLE_HAVE_MMAP
+    int fd = ::open(fname.c_str(), O_WRONLY | O_CREAT, 0666);
+    if (fd < 0) {
+        openError(fname);
+    }
+    bool written = ::lseek(fd, static_cast<off_t>(offset), SEEK_SET) >= 0
+        && writeAll(fd, contents.data(), contents.size())
+        && ::ftruncate(fd, static_cast<off_t>(end)) == 0;
+    if (sync) {
+        written = ::fsync(fd) == 0 && written;
+    }
+    written = ::close(fd) == 0 && written;
+#else
+    static_cast<void>(sync);
+    if (!std::filesystem::exists(fname)) {
+        std::ofstream{ fname, std::ios::binary };
+    }
+    std::fstream fwriter{ fname,
+        std::ios::in | std::ios::out | std::ios::binary };
+    if (!fwriter) {
+        openError(fname);
+    }
+    fwriter.seekp(static_cast<std::streamoff>(offset));
+    fwriter.write(contents.data(), contents.size());
+    fwriter.close();
+    std::error_code resizeError;
+    std::filesystem::resize_file(fname, end, resizeError);
+    bool written = static_cast<bool>(fwriter) && !resizeError;
+#endif
+
+    if (!written) {
+        throw std::ios_base::failure("Error writing file '" + fname + "'");
+    }
+}
+
+
+/**
+ * Resolve any symlinks in the path to a file that is to be replaced, so that
+ * replaceFile() replaces the file the path refers to, rather than a symlink
+ * to it.
+ *
+ * @param fname path to the file, which need not exist
+ * @return the path with its symlinks resolved, or fname if they could not be
+ */
+std::string resolveReplacementPath(const std::string& fname) {
+    std::error_code resolveError;
+    const std::filesystem::path resolved =
+        std::filesystem::weakly_canonical(fname, resolveError);
+    return resolveError ? fname : resolved.string();
+}
+
+
+/**
+ * Create a new, empty file to write a replacement for another into, before
+ * renaming it over the original with replaceFile(). It is created in the
+ * original's directory, so that the rename cannot cross file systems, under
+ * a name that no file has. Creation is exclusive, so fails rather than open
+ * a file given that name in the meantime. If the original exists, the new
+ * file is given its permissions, and its owner where permitted, so that its
+ * replacement keeps them.
+ *
+ * @param fname path to the file to be replaced, with its symlinks resolved
+ *              by resolveReplacementPath()
+ * @return path to the new file
+ * @throw std::ios_base::failure if the file could not be created
+ */
+std::string createReplacementFile(const std::string& fname) {
+    std::string tempName = fname + ".tmp";
+#if JRLE_HAVE_MMAP
+    struct stat original;
+    const bool replacing = ::stat(fname.c_str(), &original) == 0;
+    // Until it has the original's permissions, only its creator may use it
+    const mode_t mode = replacing ? 0600 : 0666;
+    int fd;
+    for (unsigned i{1}; (fd = ::open(tempName.c_str(),
+            O_WRONLY | O_CREAT | O_EXCL, mode)) < 0; i++) {
+        if (errno != EEXIST) {
+            openError(tempName);
+        }
+        tempName = fname + "." + std::to_string(i) + ".tmp";
+    }
+
+    bool created{true};
+    if (replacing) {
+        // Only privileged users may give a file away, so the owner is kept
+        // if it cannot be changed, and the group if that cannot either.
+        // Changing either clears the set-user-ID bits, so comes first.
+        if (::fchown(fd, original.st_uid, original.st_gid) != 0
+                && ::fchown(fd, static_cast<uid_t>(-1), original.st_gid)
+                    != 0) {
+            // Keep the creator's owner and group
+        }
+        created = ::fchmod(fd, original.st_mode & 07777) == 0;
+    }
+    created = ::close(fd) == 0 && created;
+#else
+    std::error_code statusError;
+    const std::filesystem::file_status original =
+        std::filesystem::status(fname, statusError);
+    // Opening with "x" fails if the file exists
+    std::FILE* file;
+    for (unsigned i{1}; (file = std::fopen(tempName.c_str(), "wbx"))
+            == nullptr; i++) {
+        if (!std::filesystem::exists(tempName)) {
+            openError(tempName);
+        }
+        tempName = fname + "." + std::to_string(i) + ".tmp";
+    }
+
+    bool created = std::fclose(file) == 0;
+    if (!statusError && std::filesystem::exists(original)) {
+        std::filesystem::permissions(tempName, original.permissions(),
+            statusError);
+        created = !statusError && created;
+    }
+#endif
+
+    if (!created) {
+        std::remove(tempName.c_str());
+        openError(tempName);
+    }
+    return tempName;
+}
+
+
+/**
+ * Replace a file with another, by renaming the replacement over the original.
+ * Where supported, the rename is atomic, so the file is never seen partly
+ * written, and is flushed to disk along with its directory. Write and sync
+ * the replacement in the same directory first, so that a crash leaves either
+ * the whole original or the whole replacement.
+ *
+ * @param fname path to the file to replace, which need not exist
+ * @param replacementName path to the file to replace it with
+ * @throw std::ios_base::failure if the file could not be replaced
+ */
+void replaceFile(const std::string& fname,
+        const std::string& replacementName) {
+    bool renamed = std::rename(replacementName.c_str(), fname.c_str()) == 0;
+#if JRLE_HAVE_MMAP
+    if (renamed) {
+        // Make the rename itself durable. Not every file system can sync a
+        // directory, and the file is already in place, so errors are ignored.
+        std::string dir = std::filesystem::path(fname).parent_path().string();
+        int dirFd = ::open(dir.empty() ? "." : dir.c_str(),
+            O_RDONLY | O_DIRECTORY);
+        if (dirFd >= 0) {
+            ::fsync(dirFd);
+            ::close(dirFd);
+        }
+    }
+#else
+    // Renaming over an existing file is not permitted on all platforms
+    if (!renamed) {
+        std::remove(fname.c_str());
+        renamed = std::rename(replacementName.c_str(), fname.c_str()) == 0;
+    }
+#endif
+    if (!renamed) {
+        throw std::ios_base::failure("Error replacing file '" + fname
+            + "' - Result has been left in '" + replacementName + "'");
+    }
+}
+
+
+/**
+ * Read the next block of standard input, with a single unbuffered read
+ * where possible.
+ *
+ * @param data pointer to space for the block
+ * @param capacity the number of bytes available at data
+ * @return the number of bytes read, or 0 at the end of the input
+ * @throw std::ios_base::failure if standard input could not be read
+ */
+std::size_t readStandardInput(char* data, std::size_t capacity) {
+#if JRLE_HAVE_MMAP
+    while (true) {
+        ssize_t count = ::read(STDIN_FILENO, data, capacity);
+        if (count >= 0) {
+            return static_cast<std::size_t>(count);
+        } else if (errno != EINTR) {
+            throw std::ios_base::failure("Error reading standard input");
+        }
+    }
+#else
+    std::cin.read(data, static_cast<std::streamsize>(capacity));
+    if (std::cin.bad()) {
+        throw std::ios_base::failure("Error reading standard input");
+    }
+    return static_cast<std::size_t>(std::cin.gcount());
+#endif
+}
+
+
+/**
+ * Write a block of bytes to standard output, with unbuffered writes where
+ * possible.
+ *
+ * @param data pointer to the bytes to write
+ * @param length the number of bytes to write
+ * @throw std::ios_base::failure if standard output could not be written
+ */
+void writeStandardOutput(const char* data, std::size_t length) {
+    StandardOutputBuf out;
+    if (out.sputn(data, static_cast<std::streamsize>(length))
+            != static_cast<std::streamsize>(length)) {
+        throw std::ios_base::failure("Error writing standard output");
+    }
+}
+
+
+/**
+ * Write a single char to standard output.
+ *
+ * @param c the char to write
+ * @return c, or EOF if it could not be written
+ */
+StandardOutputBuf::int_type StandardOutputBuf::overflow(int_type c) {
+    if (traits_type::eq_int_type(c, traits_type::eof())) {
+        return traits_type::not_eof(c);
+    }
+    char byte = traits_type::to_char_type(c);
+    return xsputn(&byte, 1) == 1 ? c : traits_type::eof();
+}
+
+
+/**
+ * Write a block of chars to standard output.
+ *
+ * @param data pointer to the chars to write
+ * @param count the number of chars to write
+ * @return the number of chars written, less than count on error
+ */
+std::streamsize StandardOutputBuf::xsputn(const char* data,
+        std::streamsize count) {
+#if JRLE_HAVE_MMAP
+    std::streamsize written{0};
+    while (written < count) {
+        ssize_t result = ::write(STDOUT_FILENO, data + written,
+            static_cast<std::size_t>(count - written));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        } else if (result <= 0) {
+            break;
+        }
+        written += result;
+    }
+    return written;
+#else
+    return std::cout.rdbuf()->sputn(data, count);
+#endif
+}
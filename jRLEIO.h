@@ -0,0 +1,264 @@
+/**
+ * Memory-mapped file input and output for jRLE.
+ *
+ * Reading a file through a stream copies every byte into a buffer owned by
+ * the program before it can be en/decoded. A MappedInputFile instead maps
+ * the file into memory, so the en/decoders read the file's pages directly
+ * through a std::string_view. Likewise, a MappedOutputFile pre-sizes the
+ * output file, allocating its disk space, and maps it, so the en/decoders
+ * write their result directly into the file through an OutputBuffer.
+ *
+ * Where memory mapping is not available, or the file cannot be mapped (for
+ * example, a pipe), both fall back to buffered reads and writes, holding the
+ * whole file in memory.
+ *
+ * Pipes can instead be streamed, by reading standard input in large blocks
+ * with readStandardInput(), and writing to standard output through a
+ * StandardOutputBuf, which passes each block straight to the system.
+ *
+ * For example, to encode one file into another:
+ * MappedInputFile in{ "in.txt" };
+ * MappedOutputFile out{ "out.txt", encodedLengthBound(in.view().size()) };
+ * encode(in.view(), out.buffer());
+ * out.commit();
+ *
+ * To replace a file safely, write the result to a temporary file alongside
+ * it, made by createReplacementFile(), commit it with sync set, then rename
+ * it over the file with replaceFile().
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_IO_H
+#define JRLE_IO_H
+
+#include <cstddef>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+#include "jRLECodec.h"
+
+// Whether files can be memory-mapped on this platform
+#if defined(__unix__) || defined(__APPLE__)
+#define JRLE_HAVE_MMAP 1
+#else
+#define JRLE_HAVE_MMAP 0
+#endif
+
+
+/**
+ * A whole file opened for reading, mapped into memory where possible.
+ */
+class MappedInputFile {
+public:
+    /**
+     * Open and map a file. The file must not be modified while it is open.
+     *
+     * @param fname path to the file to read
+     * @throw std::ios_base::failure if the file could not be opened or read
+     */
+    explicit MappedInputFile(const std::string& fname);
+
+    ~MappedInputFile();
+
+    MappedInputFile(const MappedInputFile&) = delete;
+    MappedInputFile& operator=(const MappedInputFile&) = delete;
+
+    /**
+     * @return the contents of the file. Valid until the file is closed.
+     */
+    std::string_view view() const;
+
+    /**
+     * @return true if the file is memory-mapped, rather than read into memory
+     */
+    bool isMapped() const;
+
+    /**
+     * Unmap the file, invalidating view().
+     */
+    void close();
+
+private:
+    void* mapping{nullptr};
+    std::size_t mappedLength{0};
+    // The file's contents, if it could not be mapped
+    std::string contents;
+};
+
+
+/**
+ * A file opened for writing, pre-sized and mapped into memory where
+ * possible. The file is only given its final length once committed.
+ *
+ * A store to a mapping cannot report an error, so running out of disk space
+ * while writing through one would kill the process with SIGBUS. The file is
+ * therefore only mapped once disk space for all of it has been allocated.
+ * Where that is not possible, for lack of space or of support, the contents
+ * are buffered and written with plain writes on commit, which report a full
+ * disk as an error.
+ */
+class MappedOutputFile {
+public:
+    /**
+     * Create or truncate a file, and make space to write into it.
+     *
+     * @param fname path to the file to write
+     * @param capacity the maximum number of bytes that will be written. The
+     *                 buffer cannot grow beyond this if the file is mapped.
+     * @throw std::ios_base::failure if the file could not be opened
+     */
+    MappedOutputFile(const std::string& fname, std::size_t capacity);
+
+    ~MappedOutputFile();
+
+    MappedOutputFile(const MappedOutputFile&) = delete;
+    MappedOutputFile& operator=(const MappedOutputFile&) = delete;
+
+    /**
+     * @return the buffer to write the file's contents into
+     */
+    OutputBuffer& buffer();
+
+    /**
+     * @return true if the file is memory-mapped, rather than buffered
+     */
+    bool isMapped() const;
+
+    /**
+     * Finish writing the file, truncating it to the length of the buffer.
+     * The buffer must not be used afterwards.
+     *
+     * @param sync whether to flush the file to disk before returning, where
+     *             supported
+     * @throw std::ios_base::failure if the file could not be written
+     */
+    void commit(bool sync = false);
+
+private:
+    std::string name;
+    int fd{-1};
+    void* mapping{nullptr};
+    std::size_t mappedLength{0};
+    OutputBuffer out;
+};
+
+
+/**
+ * Create or truncate a file, and write the whole of a span of bytes to it
+ * with plain writes. For small files, this costs fewer system calls than
+ * mapping them with a MappedOutputFile.
+ *
+ * @param fname path to the file to write
+ * @param contents the bytes to write
+ * @param sync whether to flush the file to disk before returning, where
+ *             supported
+ * @throw std::ios_base::failure if the file could not be opened or written
+ */
+void writeWholeFile(const std::string& fname, std::string_view contents,
+    bool sync = false);
+
+
+/**
+ * Write a span of bytes into a file at an offset, creating the file if it
+ * does not exist, and discard anything in the file after them. The file is
+ * changed in place, so unlike replaceFile(), a crash may leave it partly
+ * written.
+ *
+ * @param fname path to the file to write
+ * @param offset the position in the file to write the bytes at. Must be no
+ *               greater than the length of the file.
+ * @param contents the bytes to write
+ * @param sync whether to flush the file to disk before returning, where
+ *             supported
+ * @throw std::ios_base::failure if the file could not be opened or written
+ */
+void writeFileAt(const std::string& fname, std::size_t offset,
+    std::string_view contents, bool sync = false);
+
+
+/**
+ * Resolve any symlinks in the path to a file that is to be replaced, so that
+ * replaceFile() replaces the file the path refers to, rather than a symlink
+ * to it.
+ *
+ * @param fname path to the file, which need not exist
+ * @return the path with its symlinks resolved, or fname if they could not be
+ */
+std::string resolveReplacementPath(const std::string& fname);
+
+
+/**
+ * Create a new, empty file to write a replacement for another into, before
+ * renaming it over the original with replaceFile(). It is created in the
+ * original's directory, so that the rename cannot cross file systems, under
+ * a name that no file has. Creation is exclusive, so fails rather than open
+ * a file given that name in the meantime. If the original exists, the new
+ * file is given its permissions, and its owner where permitted, so that its
+ * replacement keeps them.
+ *
+ * @param fname path to the file to be replaced, with its symlinks resolved
+ *              by resolveReplacementPath()
+ * @return path to the new file
+ * @throw std::ios_base::failure if the file could not be created
+ */
+std::string createReplacementFile(const std::string& fname);
+
+
+/**
+ * Replace a file with another, by renaming the replacement over the original.
+ * Where supported, the rename is atomic, so the file is never seen partly
+ * written, and is flushed to disk along with its directory. Write and sync
+ * the replacement in the same directory first, so that a crash leaves either
+ * the whole original or the whole replacement.
+ *
+ * @param fname path to the file to replace, which need not exist
+ * @param replacementName path to the file to replace it with
+ * @throw std::ios_base::failure if the file could not be replaced
+ */
+void replaceFile(const std::string& fname, const std::string& replacementName);
+
+
+/**
+ * The size in bytes of the blocks read from and written to pipes
+ */
+constexpr std::size_t pipeBufferSize = 1 << 20;
+
+
+/**
+ * Read the next block of standard input, with a single unbuffered read
+ * where possible.
+ *
+ * @param data pointer to space for the block
+ * @param capacity the number of bytes available at data
+ * @return the number of bytes read, or 0 at the end of the input
+ * @throw std::ios_base::failure if standard input could not be read
+ */
+std::size_t readStandardInput(char* data, std::size_t capacity);
+
+
+/**
+ * Write a block of bytes to standard output, with unbuffered writes where
+ * possible.
+ *
+ * @param data pointer to the bytes to write
+ * @param length the number of bytes to write
+ * @throw std::ios_base::failure if standard output could not be written
+ */
+void writeStandardOutput(const char* data, std::size_t length);
+
+
+/**
+ * A std::streambuf that writes to standard output with no buffer of its
+ * own, so that each block written to it is passed straight to the system.
+ * Use it with writers that buffer their own output, such as StreamEncoder.
+ */
+class StandardOutputBuf : public std::streambuf {
+protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char* data, std::streamsize count) override;
+};
+
+#endif
@@ -0,0 +1,108 @@
+/**
+ * Random-access decoding of plain run-length encoded text.
+ * See jRLEIndex.h for usage.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLEIndex.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+
+/**
+ * Build an index over encoded text, validating all of it.
+ *
+ * @param encoded the encoded text to index. Must outlive the index.
+ * @param interval the number of runs between each sample. Smaller
+ *                 intervals use more memory, but decode ranges faster.
+ * @throw std::invalid_argument if the encoded text is invalid, or
+ *        interval is 0
+ */
+RunIndex::RunIndex(std::string_view encoded, std::size_t interval) :
+        text(encoded),
+        totalDecodedLength{0},
+        totalRuns{0} {
+    if (interval == 0) {
+        throw std::invalid_argument("Run index interval must not be 0");
+    }
+
+    EncodedRunReader reader{ text };
+    std::size_t count;
+    char c;
+    // The reader state before each run is where that run can be re-read from
+    std::size_t runPos = reader.position();
+    bool runInLongSeq = reader.inLongSeq();
+
+    while (reader.next(count, c)) {
+        if (totalRuns % interval == 0) {
+            samples.push_back({ runPos, totalDecodedLength, runInLongSeq });
+        }
+        if (count > std::numeric_limits<std::size_t>::max()
+                - totalDecodedLength) {
+            throw std::invalid_argument(
+                "Invalid encoded sequence. Decoded length too large");
+        }
+        totalDecodedLength += count;
+        totalRuns++;
+
+        runPos = reader.position();
+        runInLongSeq = reader.inLongSeq();
+    }
+}
+
+
+/**
+ * @return the length in bytes of the whole decoded text
+ */
+std::size_t RunIndex::decodedLength() const {
+    return totalDecodedLength;
+}
+
+
+/**
+ * @return the number of runs in the encoded text
+ */
+std::size_t RunIndex::runCount() const {
+    return totalRuns;
+}
+
+
+/**
+ * Decode only the given range of the decoded text, writing the result to
+ * the end of an OutputBuffer.
+ *
+ * @param offset the position in the decoded text of the first char
+ * @param length the number of chars to decode
+ * @param out the buffer to append the decoded range to
+ * @throw std::out_of_range if the range extends past the decoded text
+ */
+void RunIndex::decodeRange(std::size_t offset, std::size_t length,
+        OutputBuffer& out) const {
+    if (offset > totalDecodedLength
+            || length > totalDecodedLength - offset) {
+        throw std::out_of_range("Range [" + std::to_string(offset) + ", +"
+            + std::to_string(length) + ") exceeds decoded length "
+            + std::to_string(totalDecodedLength));
+    }
+    if (length == 0) {
+        return;
+    }
+
+    // Find the last sampled run starting at or before offset.
+    // The first sample is always the first run, at decoded offset 0.
+    auto after = std::upper_bound(samples.begin(), samples.end(), offset,
+        [](std::size_t value, const Sample& sample) {
+            return value < sample.decodedOffset;
+        });
+    const Sample& start = *(after - 1);
+
+    // The text was fully validated when indexed, so this cannot fall short
+    EncodedRunReader reader{ text, start.encodedPos, start.inLongSeq };
+    decodeRunsInRange(reader, start.decodedOffset, offset, length,
+        out.prepare(length));
+    out.commit(length);
+}
@@ -0,0 +1,91 @@
+/**
+ * Random-access decoding of plain run-length encoded text.
+ *
+ * Decoding a range of plain encoded text ordinarily requires reading every
+ * token before it. A RunIndex is built once over the encoded text, by
+ * recording the encoded and decoded position of every Kth run - a sampled
+ * prefix sum of run lengths. A range is then decoded by binary searching
+ * the samples for the closest preceding run, and reading only from there:
+ * O(log n + K + length) rather than O(n).
+ *
+ * For example, to decode 100 bytes from the middle of a large encoding:
+ * RunIndex index{ encoded };
+ * OutputBuffer out;
+ * index.decodeRange(1000000, 100, out);
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_INDEX_H
+#define JRLE_INDEX_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "jRLECodec.h"
+
+
+/**
+ * The default number of runs between each sample in a RunIndex
+ */
+constexpr std::size_t defaultRunIndexInterval = 64;
+
+
+/**
+ * A sampled index of the runs in plain run-length encoded text, allowing
+ * any range of the decoded text to be decoded directly.
+ */
+class RunIndex {
+public:
+    /**
+     * Build an index over encoded text, validating all of it.
+     *
+     * @param encoded the encoded text to index. Must outlive the index.
+     * @param interval the number of runs between each sample. Smaller
+     *                 intervals use more memory, but decode ranges faster.
+     * @throw std::invalid_argument if the encoded text is invalid, or
+     *        interval is 0
+     */
+    explicit RunIndex(std::string_view encoded,
+        std::size_t interval = defaultRunIndexInterval);
+
+    /**
+     * @return the length in bytes of the whole decoded text
+     */
+    std::size_t decodedLength() const;
+
+    /**
+     * @return the number of runs in the encoded text
+     */
+    std::size_t runCount() const;
+
+    /**
+     * Decode only the given range of the decoded text, writing the result to
+     * the end of an OutputBuffer.
+     *
+     * @param offset the position in the decoded text of the first char
+     * @param length the number of chars to decode
+     * @param out the buffer to append the decoded range to
+     * @throw std::out_of_range if the range extends past the decoded text
+     */
+    void decodeRange(std::size_t offset, std::size_t length,
+        OutputBuffer& out) const;
+
+private:
+    // The position of a run in both the encoded and decoded text,
+    // and the reader state needed to resume reading from it
+    struct Sample {
+        std::size_t encodedPos;
+        std::size_t decodedOffset;
+        bool inLongSeq;
+    };
+
+    std::string_view text;
+    std::vector<Sample> samples;
+    std::size_t totalDecodedLength;
+    std::size_t totalRuns;
+};
+
+#endif
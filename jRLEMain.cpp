@@ -0,0 +1,919 @@
+/**
+ * Command line interface for the jRLE run-length encoder.
+ * 
+ * Invoke from the command line with the function as the first argument,
+ * and your file path as the last argument. See main() for all options.
+ * File must have the extension ".txt" and use ASCII encoding, unless in
+ * binary mode.
+ * 
+ * Many files may be processed in one invocation, by passing several paths,
+ * a directory, or a list of paths on stdin. See runBatch().
+ * 
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLE.h"
+#include "jRLEIO.h"
+#include "jRLEThreads.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <ios>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+
+/**
+ * How to process each file, as chosen on the command line.
+ */
+struct Options {
+    // Whether to decode, rather than encode
+    bool decode{false};
+    // The number of threads to use, where 0 uses all hardware threads
+    unsigned threads{1};
+    // Whether to encode into a block container
+    bool container{false};
+    // Whether to en/decode files of any kind, in the binary format
+    bool binary{false};
+    // Whether to encode text estimated to expand into a container instead
+    bool adaptive{false};
+    // Whether to encode into the hybrid literal/run format
+    bool hybrid{false};
+};
+
+
+/**
+ * Report an invalid command line to the user.
+ * 
+ * @param message description of the problem
+ * @throw std::invalid_argument always
+ */
+[[noreturn]] static void argumentError(const std::string& message) {
+    std::cerr << message << std::endl;
+    throw std::invalid_argument(message);
+}
+
+
+/**
+ * Describe an error to the user. The message of a std::ios_base::failure
+ * ends with a description of its error code, such as ": iostream error",
+ * which adds nothing to the path and reason before it, so is removed.
+ * 
+ * @param e the error to describe
+ * @return the message to show the user
+ */
+static std::string describeError(const std::exception& e) {
+    std::string message = e.what();
+    if (const auto* failure = dynamic_cast<const std::ios_base::failure*>(
+            &e)) {
+        const std::string suffix = ": " + failure->code().message();
+        if (message.size() > suffix.size()
+                && message.compare(message.size() - suffix.size(),
+                    suffix.size(), suffix) == 0) {
+            message.resize(message.size() - suffix.size());
+        }
+    }
+    return message;
+}
+
+
+/**
+ * Run-length encode or decode text, as chosen by the options.
+ * The space needed for the result is found first, and the result is then
+ * written straight into a buffer with at least that capacity.
+ * 
+ * Plain encoded text is always decoded sequentially. Containers, binary
+ * encoded data and hybrid encoded text are detected and decoded
+ * automatically.
+ * 
+ * In adaptive mode, text that a sample estimates would expand once encoded
+ * is encoded into a container instead, so that its incompressible blocks
+ * are stored raw rather than encoded.
+ * 
+ * @param in the text to en/decode
+ * @param options how to en/decode the text
+ * @param makeOutput called once with the capacity needed for the result,
+ *                   returning the empty OutputBuffer to write it into
+ * @throw std::invalid_argument if decoding, and the text is not validly
+ *        encoded
+ */
+template <typename MakeOutput>
+static void transform(std::string_view in, const Options& options,
+        MakeOutput makeOutput) {
+    if (options.decode && isContainer(in)) {
+        ContainerReader reader{ in };
+        OutputBuffer& out = makeOutput(reader.decodedLength());
+        reader.decode(out, options.threads);
+    } else if (options.decode && isBinaryEncoded(in)) {
+        std::size_t length = binaryDecodedLength(in);
+        OutputBuffer& out = makeOutput(length);
+        out.commit(decodeBinaryInto(in, out.prepare(length), length));
+    } else if (options.decode && isHybridEncoded(in)) {
+        std::size_t length = hybridDecodedLength(in);
+        OutputBuffer& out = makeOutput(length);
+        out.commit(decodeHybridInto(in, out.prepare(length), length));
+    } else if (options.decode) {
+        // Size the output exactly, then decode directly into it
+        std::size_t length = decodedLength(in);
+        OutputBuffer& out = makeOutput(length);
+        out.commit(decodeInto(in, out.prepare(length), length));
+    } else if (options.binary) {
+        encodeBinary(in, makeOutput(binaryEncodedLengthBound(in.length())));
+    } else if (options.hybrid) {
+        encodeHybrid(in, makeOutput(hybridEncodedLengthBound(in.length())));
+    } else if (options.container
+            || (options.adaptive && estimateEncodedRatio(in) >= 1)) {
+        encodeContainer(in, makeOutput(containerLengthBound(in.length())),
+            defaultContainerBlockSize, options.threads);
+    } else if (options.threads != 1) {
+        encodeParallel(in, makeOutput(encodedLengthBound(in.length())),
+            options.threads);
+    } else {
+        encode(in, makeOutput(encodedLengthBound(in.length())));
+    }
+}
+
+
+/**
+ * Add the lengths and runs of an en/decoded text to a CodecStats.
+ * 
+ * @param options how the text was en/decoded
+ * @param in the text before en/decoding
+ * @param out the text after en/decoding
+ * @param stats the statistics to add to, or null to do nothing
+ */
+static void countRuns(const Options& options, std::string_view in,
+        std::string_view out, CodecStats* stats) {
+    if (stats == nullptr) {
+        return;
+    }
+    // Runs are of the unencoded text, whichever way it was processed
+    std::string_view unencoded = options.decode ? out : in;
+    RunCounter counter;
+    counter.write(unencoded.data(), unencoded.size());
+    stats->runs.merge(counter.finish());
+    stats->bytesIn += in.size();
+    stats->bytesOut += out.size();
+}
+
+
+/**
+ * Run-length encode or decode a file, and write the result to another, or
+ * back to the same file.
+ * The file is memory-mapped and en/decoded in place, and the result is
+ * written to a temporary file alongside the output. Once processing has
+ * succeeded and the result is synced to disk, the temporary file is renamed
+ * over the output, so the output is never left partly written, and the
+ * input is never overwritten before it has been read.
+ * 
+ * @param fileName path to the file to process
+ * @param outputName path to write the result to, which may be fileName
+ * @param options how to en/decode the file
+ * @param scratch a buffer to en/decode into, which is then written to the
+ *                file in one go, and may be reused for the next file.
+ *                If null, the result is written straight into a mapped
+ *                temporary file instead.
+ * @param stats statistics to add the file's to, or null to gather none
+ * @return the lengths of the file before and after processing
+ * @throw std::ios_base::failure if the file could not be read or written
+ * @throw std::invalid_argument if decoding, and the file is not validly
+ *        encoded
+ */
+static StreamTotals processFile(const std::string& fileName,
+        const std::string& outputName, const Options& options,
+        OutputBuffer* scratch, CodecStats* stats) {
+    // Replace the file that a symlink refers to, not the symlink itself
+    const std::string targetName = resolveReplacementPath(outputName);
+    const std::string tempName = createReplacementFile(targetName);
+    const Stage codecStage = options.decode ? Stage::decode : Stage::encode;
+    StreamTotals totals{};
+    try {
+        MappedInputFile freader = [&]() {
+            StageTimer timer{ stats, Stage::read };
+            return MappedInputFile{ fileName };
+        }();
+        std::string_view fileText = freader.view();
+        totals.bytesIn = fileText.length();
+
+        if (scratch != nullptr) {
+            {
+                StageTimer timer{ stats, codecStage };
+                transform(fileText, options,
+                    [scratch](std::size_t capacity) -> OutputBuffer& {
+                        scratch->clear();
+                        scratch->reserve(capacity);
+                        return *scratch;
+                    });
+            }
+            totals.bytesOut = scratch->size();
+            countRuns(options, fileText, scratch->view(), stats);
+            StageTimer timer{ stats, Stage::write };
+            writeWholeFile(tempName, scratch->view(), true);
+        } else {
+            std::optional<MappedOutputFile> fwriter;
+            {
+                StageTimer timer{ stats, codecStage };
+                transform(fileText, options,
+                    [&](std::size_t capacity) -> OutputBuffer& {
+                        fwriter.emplace(tempName, capacity);
+                        return fwriter->buffer();
+                    });
+            }
+            totals.bytesOut = fwriter->buffer().size();
+            countRuns(options, fileText, fwriter->buffer().view(), stats);
+            StageTimer timer{ stats, Stage::write };
+            fwriter->commit(true);
+        }
+    } catch (...) {
+        // Leave the original untouched if anything goes wrong
+        std::remove(tempName.c_str());
+        throw;
+    }
+    StageTimer timer{ stats, Stage::write };
+    replaceFile(targetName, tempName);
+    return totals;
+}
+
+
+/**
+ * A std::streambuf that counts the runs in everything written to it, before
+ * passing it on to another.
+ */
+class RunCountingBuf : public std::streambuf {
+public:
+    /**
+     * @param next the std::streambuf to pass written chars on to
+     * @param counter the counter to count written runs with
+     */
+    RunCountingBuf(std::streambuf& next, RunCounter& counter) :
+            next(next),
+            counter(counter) {}
+
+protected:
+    int_type overflow(int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+        }
+        char byte = traits_type::to_char_type(c);
+        return xsputn(&byte, 1) == 1 ? c : traits_type::eof();
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize count) override {
+        counter.write(data, static_cast<std::size_t>(count));
+        return next.sputn(data, count);
+    }
+
+private:
+    std::streambuf& next;
+    RunCounter& counter;
+};
+
+
+/**
+ * Run-length encode or decode standard input into standard output, as it
+ * arrives. Input is read in large blocks, fed to the streaming en/decoder,
+ * and its output written as each block is produced, with no temporary file.
+ * Encoding with more than one thread uses encodePipelined(), so the next
+ * block is read while the last is encoded and written.
+ * Only plain encoded text is supported.
+ * 
+ * @param options how to en/decode the input
+ * @param stats statistics to add the input's to, or null to gather none.
+ *              The stages overlap, so only the total time is measured.
+ * @return the number of bytes read and written
+ * @throw std::ios_base::failure if standard input or output could not be used
+ * @throw std::invalid_argument if decoding, and the input is not validly
+ *        encoded
+ */
+static StreamTotals processPipe(const Options& options, CodecStats* stats) {
+    StandardOutputBuf outBuf;
+    RunCounter counter;
+    // When decoding, the unencoded text is the output
+    RunCountingBuf countingBuf{ outBuf, counter };
+    std::ostream out{ stats != nullptr && options.decode
+        ? static_cast<std::streambuf*>(&countingBuf) : &outBuf };
+    std::vector<char> block(pipeBufferSize);
+
+    auto read = [&](char* data, std::size_t capacity) {
+        std::size_t length = readStandardInput(data, capacity);
+        if (stats != nullptr && !options.decode) {
+            counter.write(data, length);
+        }
+        return length;
+    };
+    auto run = [&](auto& coder) {
+        std::size_t length;
+        while ((length = read(block.data(), block.size())) != 0) {
+            coder.write(block.data(), length);
+        }
+        coder.finish();
+        return StreamTotals{ coder.bytesIn(), coder.bytesOut() };
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    StreamTotals totals;
+    if (options.decode) {
+        StreamDecoder decoder{ out, pipeBufferSize };
+        totals = run(decoder);
+    } else if (options.threads != 1) {
+        // Overlap reading, encoding and writing on their own threads
+        totals = encodePipelined(read, writeStandardOutput, options.threads,
+            pipeBufferSize);
+    } else {
+        StreamEncoder encoder{ out, pipeBufferSize };
+        totals = run(encoder);
+    }
+
+    if (stats != nullptr) {
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        stats->bytesIn += totals.bytesIn;
+        stats->bytesOut += totals.bytesOut;
+        stats->runs.merge(counter.finish());
+        stats->wallSeconds += elapsed.count();
+    }
+    return totals;
+}
+
+
+/**
+ * Run-length encode a file, or standard input, and append the result to a
+ * plain encoded file, as if it had been encoded along with the text the
+ * encoded file already holds. Only the new text is read and encoded, and
+ * only the last eToken of the encoded file is rewritten.
+ * 
+ * The state of the end of the encoded file is kept in a sidecar file next
+ * to it (see jRLEAppend.h). If the sidecar is missing, or no longer matches
+ * the encoded file, the whole encoded file is read once to rebuild it.
+ * The encoded file is synced before the sidecar is replaced, so a crash
+ * leaves at worst a sidecar that no longer matches. The encoded file is
+ * changed in place, so a crash while it is written can leave it partly
+ * written.
+ * 
+ * @param inputName path to the file to encode, or - for standard input,
+ *                  which is read in blocks
+ * @param encodedName path to the encoded file to append to, which is
+ *                    created if it does not exist
+ * @param stats statistics to add the input's to, or null to gather none
+ * @return the number of bytes encoded, and the number of bytes the encoded
+ *         file grew by
+ * @throw std::ios_base::failure if a file could not be read or written
+ * @throw std::invalid_argument if the state had to be rebuilt, and the
+ *        encoded file is not validly encoded
+ */
+static StreamTotals processAppend(const std::string& inputName,
+        const std::string& encodedName, CodecStats* stats) {
+    const std::string stateName = encodedName + ".state";
+    AppendState state;
+    {
+        StageTimer timer{ stats, Stage::read };
+        if (std::filesystem::exists(encodedName)) {
+            MappedInputFile encoded{ encodedName };
+            bool loaded{false};
+            if (std::filesystem::exists(stateName)) {
+                MappedInputFile saved{ stateName };
+                loaded = parseAppendState(saved.view(), state)
+                    && matchesAppendState(encoded.view(), state);
+            }
+            if (!loaded) {
+                state = scanAppendState(encoded.view());
+            }
+        }
+    }
+    const std::size_t initialLength = state.encodedLength;
+    RunCounter counter;
+    OutputBuffer out;
+    StreamTotals totals{};
+
+    // Encode a block of new text, and write it over the end of the file
+    auto append = [&](std::string_view block, bool sync) {
+        if (stats != nullptr) {
+            counter.write(block.data(), block.size());
+        }
+        totals.bytesIn += block.size();
+        out.clear();
+        std::size_t offset;
+        {
+            StageTimer timer{ stats, Stage::encode };
+            offset = encodeAppend(block, state, out);
+        }
+        StageTimer timer{ stats, Stage::write };
+        writeFileAt(encodedName, offset, out.view(), sync);
+    };
+
+    if (inputName == "-") {
+        // Hold each block back until the next is read, so that only the
+        // last write needs to be synced
+        std::vector<char> block(pipeBufferSize);
+        std::vector<char> next(pipeBufferSize);
+        std::size_t length = readStandardInput(block.data(), block.size());
+        while (true) {
+            std::size_t nextLength = length == 0 ? 0
+                : readStandardInput(next.data(), next.size());
+            append({ block.data(), length }, nextLength == 0);
+            if (nextLength == 0) {
+                break;
+            }
+            block.swap(next);
+            length = nextLength;
+        }
+    } else {
+        MappedInputFile input = [&]() {
+            StageTimer timer{ stats, Stage::read };
+            return MappedInputFile{ inputName };
+        }();
+        append(input.view(), true);
+    }
+
+    {
+        StageTimer timer{ stats, Stage::write };
+        const std::string targetName = resolveReplacementPath(stateName);
+        const std::string tempName = createReplacementFile(targetName);
+        try {
+            writeWholeFile(tempName, serializeAppendState(state), true);
+        } catch (...) {
+            std::remove(tempName.c_str());
+            throw;
+        }
+        replaceFile(targetName, tempName);
+    }
+    totals.bytesOut = state.encodedLength - initialLength;
+    if (stats != nullptr) {
+        stats->bytesIn += totals.bytesIn;
+        stats->bytesOut += totals.bytesOut;
+        stats->runs.merge(counter.finish());
+    }
+    return totals;
+}
+
+
+/**
+ * Describe the ratio of unencoded length to encoded length, for reporting.
+ * The ratio is undefined when no text was processed, or when appending
+ * added nothing to the encoded length, as when the last eToken is
+ * rewritten without growing, so is then described in words.
+ * 
+ * @param options how the files were processed
+ * @param totals the lengths of the files before and after processing
+ * @return the ratio of unencoded length to encoded length, as text
+ */
+static std::string formatCompressionRatio(const Options& options,
+        const StreamTotals& totals) {
+    const std::size_t unencoded =
+        options.decode ? totals.bytesOut : totals.bytesIn;
+    const std::size_t encoded =
+        options.decode ? totals.bytesIn : totals.bytesOut;
+    if (encoded == 0) {
+        return unencoded == 0 ? "n/a (no input)"
+            : "n/a (no encoded length added)";
+    }
+    return std::to_string(static_cast<float>(unencoded) /
+        static_cast<float>(encoded));
+}
+
+
+/**
+ * Add a path given for batch mode to the list of files to process.
+ * Directories are searched recursively. Unless in binary mode, only the
+ * files found with the extension .txt are added.
+ * 
+ * @param path the path to a file or directory
+ * @param options how the files will be processed
+ * @param files the list to add the files to
+ * @throw std::invalid_argument if path names a file without the extension
+ *        .txt, unless in binary mode or decoding
+ * @throw std::filesystem::filesystem_error if a directory could not be read
+ */
+static void addBatchPath(const std::string& path, const Options& options,
+        std::vector<std::string>& files) {
+    namespace fs = std::filesystem;
+    if (!fs::is_directory(path)) {
+        if (!options.binary && !options.decode) {
+            validateFilePath(path);
+        }
+        files.push_back(path);
+        return;
+    }
+
+    for (const fs::directory_entry& entry :
+            fs::recursive_directory_iterator(path)) {
+        if (entry.is_regular_file()
+                && (options.binary || entry.path().extension() == ".txt")) {
+            files.push_back(entry.path().string());
+        }
+    }
+}
+
+
+/**
+ * Run-length encode or decode many files, spread across a pool of threads,
+ * and report the totals once all have finished. Each file is processed on
+ * a single thread, into an output buffer reused by its thread, and files
+ * are started largest first, with idle threads stealing queued files from
+ * busy ones. A file that fails to process is reported and left untouched,
+ * and does not stop the others.
+ * 
+ * @param files paths to the files to process
+ * @param options how to en/decode the files. The thread count is the number
+ *                of files to process at once.
+ * @param stats statistics to add those of the files processed to, or null
+ *              to gather none
+ * @throw std::runtime_error if any file could not be processed
+ */
+static void runBatch(std::vector<std::string> files, const Options& options,
+        CodecStats* stats) {
+    // Each file must only be processed once, or its temporary files clash
+    for (std::string& file : files) {
+        file = std::filesystem::absolute(file).lexically_normal().string();
+    }
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+
+    // Start the largest files first, so that none is left until the end
+    std::vector<std::pair<std::uintmax_t, std::string>> bySize;
+    bySize.reserve(files.size());
+    for (std::string& file : files) {
+        std::error_code error;
+        std::uintmax_t size = std::filesystem::file_size(file, error);
+        bySize.emplace_back(error ? 0 : size, std::move(file));
+    }
+    std::stable_sort(bySize.begin(), bySize.end(),
+        [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    const unsigned workers = resolveThreadCount(options.threads);
+    Options fileOptions = options;
+    fileOptions.threads = 1;
+
+    // Each worker's own buffer and totals, so that they share nothing
+    std::vector<OutputBuffer> scratch(workers);
+    std::vector<StreamTotals> totals(workers, StreamTotals{});
+    std::vector<std::size_t> failures(workers, 0);
+    std::vector<CodecStats> workerStats(stats != nullptr ? workers : 0);
+    std::mutex reportLock;
+
+    const auto start = std::chrono::steady_clock::now();
+    runWorkStealing(bySize.size(), workers,
+        [&](std::size_t i, std::size_t worker) {
+            const std::string& file = bySize[i].second;
+            try {
+                // Only count the statistics of files that succeed
+                CodecStats fileStats;
+                StreamTotals fileTotals = processFile(file, file,
+                    fileOptions, &scratch[worker],
+                    stats != nullptr ? &fileStats : nullptr);
+                totals[worker].bytesIn += fileTotals.bytesIn;
+                totals[worker].bytesOut += fileTotals.bytesOut;
+                if (stats != nullptr) {
+                    workerStats[worker].merge(fileStats);
+                }
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> guard{ reportLock };
+                std::cerr << file << ": " << describeError(e) << '\n';
+                failures[worker]++;
+            }
+        });
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (stats != nullptr) {
+        for (const CodecStats& workerStat : workerStats) {
+            stats->merge(workerStat);
+        }
+        stats->wallSeconds = elapsed.count();
+    }
+
+    StreamTotals total{};
+    std::size_t failed{0};
+    for (unsigned i{0}; i < workers; i++) {
+        total.bytesIn += totals[i].bytesIn;
+        total.bytesOut += totals[i].bytesOut;
+        failed += failures[i];
+    }
+
+    // Report the totals across every file
+    const double megabytes = static_cast<double>(total.bytesIn) / 1e6;
+    std::cout << "Files processed: " + std::to_string(bySize.size() - failed)
+        + "\nFiles failed: " + std::to_string(failed)
+        + "\nOriginal length: " + std::to_string(total.bytesIn)
+        + "\nNew length: " + std::to_string(total.bytesOut)
+        + "\nCompression ratio: "
+        + formatCompressionRatio(options, total)
+        + "\nThroughput: " + std::to_string(megabytes / elapsed.count())
+        + " MB/s\n";
+
+    if (failed != 0) {
+        throw std::runtime_error(std::to_string(failed)
+            + " file(s) could not be processed");
+    }
+}
+
+
+/**
+ * Run-length encode or decode the given text file, and write back the result,
+ * or write it to the path given with -o.
+ * The file is memory-mapped and en/decoded in place, and the result is
+ * written directly into a mapped temporary file alongside the output, which
+ * is synced and renamed over the output only once processing has succeeded.
+ * 
+ * Encoding may optionally be split across multiple threads. Plain encoded
+ * text is always decoded sequentially.
+ * 
+ * Encoding may optionally produce a block container (see jRLEContainer.h),
+ * which can be decoded on multiple threads. Containers are detected and
+ * decoded automatically. Adaptive mode estimates from samples whether the
+ * text would expand once encoded, and if so, encodes it into a container
+ * in which blocks that would expand are stored raw.
+ * 
+ * Binary mode en/decodes files of any kind, using the binary format from
+ * jRLEBinary.h. Binary encoded files are detected and decoded automatically.
+ * 
+ * Encoding may optionally use the hybrid format from jRLEHybrid.h, which
+ * stores stretches of short runs as literals. Hybrid encoded files are
+ * detected and decoded automatically.
+ * 
+ * Batch mode processes many files at once (see runBatch()), and is used
+ * when more than one path is given, when a path is a directory, or when -m
+ * is given.
+ * 
+ * Pipe mode en/decodes standard input into standard output as it arrives,
+ * and is used when the path is -. The report is written to standard error.
+ * 
+ * Append mode encodes a file, or standard input, onto the end of the plain
+ * encoded file given with -o, reading and encoding only the new text (see
+ * processAppend()).
+ * 
+ * @param argc The number of arguments passed in argv
+ * @param argv An array of strings, defining the arguments below:
+ * argv[0] is the function to perform: -e for encode, -d for decode.
+ * Optionally followed by -j and the number of threads to use,
+ * where 0 uses all hardware threads. Defaults to 1, or to 0 in batch mode,
+ * where it is the number of files processed at once.
+ * Optionally followed by -c, to encode into a block container.
+ * Optionally followed by -b, to use binary mode.
+ * Optionally followed by -a, to use adaptive mode, encoding text estimated
+ * to expand into a block container, with its incompressible blocks raw.
+ * Optionally followed by -l, to encode into the hybrid literal/run format.
+ * Optionally followed by -m, to read a list of paths from stdin, one per
+ * line, in batch mode.
+ * Optionally followed by -A, to append the encoded input to the plain
+ * encoded file given with -o, rather than replacing it. Only valid when
+ * encoding a single input file, or -.
+ * Optionally followed by -o and the path to write the result to, instead
+ * of replacing the input file. Only valid with a single input file.
+ * Optionally followed by --stats, to report statistics on the runs and the
+ * time spent in each stage, or --stats=json to report them as JSON.
+ * Unavailable if built with JRLE_STATS defined as 0.
+ * The last arguments are the paths to the input files or directories,
+ * or - for standard input. Unless in binary mode or decoding, files must
+ * have the extension .txt
+ * @throw std::invalid_argument If a required argument is missing
+ * @throw std::invalid_argument If argv[0] is neither -e nor -d.
+ * @return 0 on success, or 1 if in batch mode, and any file could not be
+ *         processed
+ * @throw std::invalid_argument If decoding, and the file is not validly encoded
+ */
+int main(int argc, char* argv[]) {
+    const std::string usage =
+        "Correct command format: jRLE.exe <-e | -d> [-j threads] "
+        "[-c | -b | -a | -l] [-m] [-A] [-o output-path] "
+#if JRLE_STATS
+        "[--stats[=json]] "
+#endif
+        "<file-path... | ->";
+
+    // Require both arguments
+    if (argc < 3) {
+        argumentError("Missing required argument. " + usage);
+    }
+
+    std::string func = std::string(argv[1]);
+    std::vector<std::string> paths;
+    Options options;
+    // Whether a thread count was given
+    bool threadsGiven{false};
+    // Whether to read paths from stdin
+    bool manifest{false};
+    // Whether to append the result to the output, rather than replace it
+    bool append{false};
+    // Where to write the result, if not back to the input file
+    std::string outputName;
+    // Statistics to report at the end, if asked for
+    std::optional<CodecStats> stats;
+    bool statsJson{false};
+
+    // Handle invalid function arguments
+    if (func != "-d" && func != "-e") {
+        argumentError("Invalid argument '" + func
+            + "' - arg1 must be behaviour flag '-e' or '-d'");
+    }
+    options.decode = func == "-d";
+
+    // Read any options, followed by the file paths
+    for (int i{2}; i < argc; i++) {
+        std::string arg = std::string(argv[i]);
+        if (arg == "-j") {
+            if (i + 1 == argc) {
+                argumentError("Missing thread count after '-j'. " + usage);
+            }
+            arg = std::string(argv[++i]);
+            try {
+                std::size_t parsed;
+                options.threads = static_cast<unsigned>(
+                    std::stoul(arg, &parsed));
+                if (parsed != arg.length()) {
+                    throw std::invalid_argument(arg);
+                }
+            } catch (const std::exception&) {
+                argumentError("Invalid thread count '" + arg
+                    + "' - must be a non-negative integer");
+            }
+            threadsGiven = true;
+        } else if (arg == "-c") {
+            options.container = true;
+        } else if (arg == "-b") {
+            options.binary = true;
+        } else if (arg == "-a") {
+            options.adaptive = true;
+        } else if (arg == "-l") {
+            options.hybrid = true;
+        } else if (arg == "-m") {
+            manifest = true;
+        } else if (arg == "-A") {
+            append = true;
+        } else if (arg == "-o") {
+            if (i + 1 == argc) {
+                argumentError("Missing output path after '-o'. " + usage);
+            }
+            outputName = std::string(argv[++i]);
+#if JRLE_STATS
+        } else if (arg == "--stats" || arg == "--stats=json") {
+            stats.emplace();
+            statsJson = arg == "--stats=json";
+#else
+        } else if (arg == "--stats" || arg == "--stats=json") {
+            argumentError("Option '--stats' is not available in this build. "
+                + usage);
+#endif
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty() && !manifest) {
+        argumentError("Missing required argument. " + usage);
+    }
+    if (options.container + options.binary + options.adaptive
+            + options.hybrid > 1) {
+        argumentError("Options '-c', '-b', '-a' and '-l' cannot be "
+            "combined. " + usage);
+    }
+
+    // Encode onto the end of an encoded file
+    if (append) {
+        if (options.decode || options.container || options.binary
+                || options.adaptive || options.hybrid || manifest
+                || paths.size() != 1 || outputName.empty()) {
+            argumentError("Option '-A' requires '-e', '-o' and a single "
+                "file path, and cannot be combined with '-c', '-b', '-a', "
+                "'-l' or '-m'. " + usage);
+        }
+        const std::string& fileName = paths.front();
+        if (fileName != "-") {
+            validateFilePath(fileName);
+        }
+        validateFilePath(outputName);
+
+        StreamTotals totals;
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            totals = processAppend(fileName, outputName,
+                stats ? &*stats : nullptr);
+        } catch (const std::exception& e) {
+            std::cerr << describeError(e) << '\n';
+            throw;
+        }
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        std::cout << "Appended length: " + std::to_string(totals.bytesIn)
+            + "\nEncoded length added: " + std::to_string(totals.bytesOut)
+            + "\nCompression ratio: "
+            + formatCompressionRatio(options, totals);
+        if (stats) {
+            stats->wallSeconds = elapsed.count();
+            std::cout << '\n' << formatStats(*stats, statsJson);
+        }
+        return 0;
+    }
+
+    // Stream standard input into standard output
+    if (!manifest && paths.size() == 1 && paths.front() == "-") {
+        if (options.container || options.binary || options.adaptive
+                || options.hybrid || !outputName.empty()) {
+            argumentError("Options '-c', '-b', '-a', '-l' and '-o' cannot be "
+                "used with '-'. " + usage);
+        }
+        StreamTotals totals;
+        try {
+            totals = processPipe(options, stats ? &*stats : nullptr);
+        } catch (const std::exception& e) {
+            std::cerr << describeError(e) << '\n';
+            throw;
+        }
+        // Standard output holds the result, so report to standard error
+        std::cerr << "Original length: " + std::to_string(totals.bytesIn)
+            + "\nNew length: " + std::to_string(totals.bytesOut)
+            + "\nCompression ratio: "
+            + formatCompressionRatio(options, totals) + '\n';
+        if (stats) {
+            std::cerr << formatStats(*stats, statsJson);
+        }
+        return 0;
+    }
+
+    // Process many files at once
+    if (manifest || paths.size() > 1
+            || std::filesystem::is_directory(paths.front())) {
+        if (!outputName.empty()) {
+            argumentError("Option '-o' requires a single file path. "
+                + usage);
+        }
+        if (!threadsGiven) {
+            options.threads = 0;
+        }
+        std::vector<std::string> files;
+        try {
+            if (manifest) {
+                std::string line;
+                while (std::getline(std::cin, line)) {
+                    if (!line.empty() && line.back() == '\r') {
+                        line.pop_back();
+                    }
+                    if (!line.empty()) {
+                        paths.push_back(line);
+                    }
+                }
+            }
+            for (const std::string& path : paths) {
+                addBatchPath(path, options, files);
+            }
+        } catch (const std::filesystem::filesystem_error& e) {
+            std::cerr << describeError(e) << '\n';
+            throw;
+        }
+        try {
+            runBatch(std::move(files), options, stats ? &*stats : nullptr);
+        } catch (const std::runtime_error& e) {
+            if (stats) {
+                std::cout << formatStats(*stats, statsJson);
+            }
+            // Some files failing is an expected outcome, not a crash
+            std::cerr << describeError(e) << '\n';
+            return 1;
+        }
+        if (stats) {
+            std::cout << formatStats(*stats, statsJson);
+        }
+        return 0;
+    }
+
+    // Validate provided file extension. Binary files may be of any kind, and
+    // encoded files are recognised by their contents, so may have any name.
+    const std::string& fileName = paths.front();
+    if (outputName.empty()) {
+        outputName = fileName;
+    }
+    if (!options.binary && !options.decode) {
+        validateFilePath(fileName);
+        validateFilePath(outputName);
+    }
+
+    // Map the file, and en/decode it straight into a mapped temporary file
+    StreamTotals totals;
+    const auto start = std::chrono::steady_clock::now();
+    try {
+        totals = processFile(fileName, outputName, options, nullptr,
+            stats ? &*stats : nullptr);
+    } catch (const std::exception& e) {
+        std::cerr << describeError(e) << '\n';
+        throw;
+    }
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    // Report the compression ratio
+    std::cout << "Original file length: " + std::to_string(totals.bytesIn)
+        + "\nNew length: " + std::to_string(totals.bytesOut)
+        + "\nCompression ratio: " + formatCompressionRatio(options, totals);
+    if (stats) {
+        stats->wallSeconds = elapsed.count();
+        std::cout << '\n' << formatStats(*stats, statsJson);
+    }
+
+    return 0;
+}
@@ -0,0 +1,368 @@
+/**
+ * Multithreaded run-length encoding for jRLE.
+ * See jRLEParallel.h for usage.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLEParallel.h"
+#include "jRLEScan.h"
+#include "jRLEThreads.h"
+
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <exception>
+#include <ios>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * Split a string into chunks of roughly equal length, each of which starts
+ * a new run.
+ *
+ * @param in the unencoded text to split
+ * @param threads the maximum number of chunks, or 0 for one per hardware thread
+ * @return the chunks, in order
+ */
+static std::vector<std::string_view> splitAtRuns(std::string_view in,
+        unsigned threads) {
+    threads = resolveThreadCount(threads);
+    std::size_t numChunks = in.size() / minParallelChunkSize;
+    if (numChunks > threads) {
+        numChunks = threads;
+    }
+    if (numChunks == 0) {
+        numChunks = 1;
+    }
+
+    std::vector<std::string_view> chunks;
+    const char* end = in.data() + in.size();
+    const char* chunkStart = in.data();
+    const std::size_t chunkSize = in.size() / numChunks;
+
+    for (std::size_t i{1}; i < numChunks; i++) {
+        const char* split = in.data() + chunkSize * i;
+        if (split <= chunkStart) {
+            continue;
+        }
+        // Move the split to the end of the run it falls in
+        split = findRunEnd(split - 1, end);
+        if (split == end) {
+            break;
+        }
+        chunks.emplace_back(chunkStart, split - chunkStart);
+        chunkStart = split;
+    }
+    chunks.emplace_back(chunkStart, end - chunkStart);
+
+    return chunks;
+}
+
+
+/**
+ * Encode each chunk of a split string into its own buffer, on its own thread.
+ *
+ * @param in the unencoded text the chunks were split from
+ * @param chunks the chunks of in, as returned by splitAtRuns()
+ * @return the encoded chunks, in order
+ */
+static std::vector<OutputBuffer> encodeChunks(std::string_view in,
+        const std::vector<std::string_view>& chunks) {
+    std::vector<OutputBuffer> encoded(chunks.size());
+
+    runOnThreads(chunks.size(), [&](std::size_t i) {
+        const std::string_view chunk = chunks[i];
+        // #-case c: the first token of a chunk needs a # if the last
+        // run of the previous chunk consisted of digits.
+        bool prevRunDigit = chunk.data() != in.data()
+            && isdigit(static_cast<unsigned char>(chunk.data()[-1]));
+        encode(chunk, encoded[i], prevRunDigit);
+    });
+
+    return encoded;
+}
+
+
+/**
+ * Run-length encode a string on multiple threads, writing the result to the
+ * end of an OutputBuffer.
+ *
+ * @param in the unencoded text to encode
+ * @param out the buffer to append the encoded text to
+ * @param threads the maximum number of threads to use.
+ *                0 uses one thread per hardware thread.
+ */
+void encodeParallel(std::string_view in, OutputBuffer& out,
+        unsigned threads) {
+    std::vector<std::string_view> chunks = splitAtRuns(in, threads);
+    if (chunks.size() == 1) {
+        encode(in, out);
+        return;
+    }
+    std::vector<OutputBuffer> encoded = encodeChunks(in, chunks);
+
+    // Find where each encoded chunk belongs in the result
+    std::vector<std::size_t> offsets(encoded.size());
+    std::size_t total{0};
+    for (std::size_t i{0}; i < encoded.size(); i++) {
+        offsets[i] = total;
+        total += encoded[i].size();
+    }
+
+    // Stitch the chunks together, copying each on its own thread
+    char* dest = out.prepare(total);
+    runOnThreads(encoded.size(), [&](std::size_t i) {
+        if (encoded[i].size() != 0) {
+            std::memcpy(dest + offsets[i], encoded[i].data(),
+                encoded[i].size());
+        }
+    });
+    out.commit(total);
+}
+
+
+/**
+ * Run-length encode a string on multiple threads, writing the result to an
+ * ostream.
+ *
+ * @param in the unencoded text to encode
+ * @param out the std::ostream to write the encoded text to
+ * @param threads the maximum number of threads to use.
+ *                0 uses one thread per hardware thread.
+ * @return the number of encoded bytes written
+ * @throw std::ios_base::failure if the output stream could not be written
+ */
+std::size_t encodeParallel(std::string_view in, std::ostream& out,
+        unsigned threads) {
+    std::vector<OutputBuffer> encoded = encodeChunks(in,
+        splitAtRuns(in, threads));
+
+    std::size_t total{0};
+    for (const OutputBuffer& chunk : encoded) {
+        out.write(chunk.data(), chunk.size());
+        total += chunk.size();
+    }
+    if (!out) {
+        throw std::ios_base::failure("Error writing encoded output stream");
+    }
+
+    return total;
+}
+
+
+/**
+ * A block of input passing through encodePipelined(), and its encoding.
+ * The first and last runs of the block are kept apart from the rest, as
+ * they may continue in the blocks either side of it.
+ */
+struct PipelineBlock {
+    std::unique_ptr<char[]> input;
+    std::size_t length{0};
+    char firstChar{0};
+    std::size_t firstCount{0};
+    // The encoded runs between the first and last runs
+    OutputBuffer body;
+    // Whether the run before the last run consisted of digits
+    bool bodyEndDigit{false};
+    char lastChar{0};
+    // 0 if the block consists of a single run
+    std::size_t lastCount{0};
+};
+
+
+/**
+ * Encode a block of input, apart from its first and last runs.
+ *
+ * @param block the block to encode. Must not be empty.
+ */
+static void encodeBlock(PipelineBlock& block) {
+    const char* begin = block.input.get();
+    const char* end = begin + block.length;
+    const char* firstEnd = findRunEnd(begin, end);
+
+    block.firstChar = *begin;
+    block.firstCount = firstEnd - begin;
+    block.body.clear();
+    block.bodyEndDigit = isdigit(static_cast<unsigned char>(*begin));
+    block.lastCount = 0;
+    if (firstEnd == end) {
+        return;
+    }
+
+    // The char at firstEnd differs from the one before it, so the last run
+    // cannot reach back into the first
+    const char* lastStart = end - 1;
+    while (lastStart[-1] == end[-1]) {
+        lastStart--;
+    }
+    block.lastChar = end[-1];
+    block.lastCount = end - lastStart;
+
+    if (lastStart != firstEnd) {
+        encode(std::string_view(firstEnd, lastStart - firstEnd), block.body,
+            block.bodyEndDigit);
+        block.bodyEndDigit = isdigit(static_cast<unsigned char>(lastStart[-1]));
+    }
+}
+
+
+/**
+ * Run-length encode input read in blocks, writing the result in blocks, with
+ * reading, encoding and writing all overlapped on their own threads.
+ * The result is identical to that of encode() on the whole input.
+ *
+ * @param read function reading the next block of input into the space
+ *             given, returning the number of bytes read, or 0 at the end of
+ *             the input. Called on the reader thread only.
+ * @param write function writing a block of encoded text. Called on the
+ *              writer thread only.
+ * @param threads the number of encoder threads to use.
+ *                0 uses one thread per hardware thread.
+ * @param blockSize the size in bytes of the blocks of input to read
+ * @return the number of bytes read and written
+ * @throw any exception thrown by read or write, after stopping all threads
+ */
+StreamTotals encodePipelined(
+        const std::function<std::size_t(char*, std::size_t)>& read,
+        const std::function<void(const char*, std::size_t)>& write,
+        unsigned threads, std::size_t blockSize) {
+    const std::size_t numWorkers = resolveThreadCount(threads);
+    // Enough blocks for each encoder to hold one while another waits for it
+    const std::size_t numBlocks = 2 * numWorkers + 2;
+
+    std::vector<PipelineBlock> blocks(numBlocks);
+    // Blocks written by the writer, to be refilled by the reader
+    SpscRing<PipelineBlock*> freeBlocks{ numBlocks };
+    for (PipelineBlock& block : blocks) {
+        block.input.reset(new char[blockSize]);
+        freeBlocks.tryPush(&block);
+    }
+
+    // Blocks are dealt to the encoders in turn, and collected from them in
+    // the same order, so need no sequence numbers. Each queue has room for
+    // every block, plus the null block marking the end of the input.
+    std::vector<std::unique_ptr<SpscRing<PipelineBlock*>>> toEncoder;
+    std::vector<std::unique_ptr<SpscRing<PipelineBlock*>>> fromEncoder;
+    for (std::size_t i{0}; i < numWorkers; i++) {
+        toEncoder.emplace_back(new SpscRing<PipelineBlock*>(numBlocks + 1));
+        fromEncoder.emplace_back(new SpscRing<PipelineBlock*>(numBlocks + 1));
+    }
+
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto guarded = [&](auto&& stage) {
+        return [&, stage]() {
+            try {
+                stage();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock{ errorMutex };
+                if (!error) {
+                    error = std::current_exception();
+                }
+                failed.store(true, std::memory_order_relaxed);
+                // Every other stage may be asleep waiting for this one
+                freeBlocks.wake();
+                for (std::size_t i{0}; i < numWorkers; i++) {
+                    toEncoder[i]->wake();
+                    fromEncoder[i]->wake();
+                }
+            }
+        };
+    };
+
+    StreamTotals totals{ 0, 0 };
+    std::vector<std::thread> pool;
+
+    pool.emplace_back(guarded([&]() {
+        PipelineBlock* block;
+        for (std::size_t i{0}; freeBlocks.pop(block, failed); i++) {
+            block->length = read(block->input.get(), blockSize);
+            if (block->length == 0) {
+                for (auto& ring : toEncoder) {
+                    ring->push(nullptr, failed);
+                }
+                return;
+            }
+            totals.bytesIn += block->length;
+            if (!toEncoder[i % numWorkers]->push(block, failed)) {
+                return;
+            }
+        }
+    }));
+
+    for (std::size_t worker{0}; worker < numWorkers; worker++) {
+        pool.emplace_back(guarded([&, worker]() {
+            PipelineBlock* block;
+            while (toEncoder[worker]->pop(block, failed)) {
+                if (block != nullptr) {
+                    encodeBlock(*block);
+                }
+                if (!fromEncoder[worker]->push(block, failed)
+                        || block == nullptr) {
+                    return;
+                }
+            }
+        }));
+    }
+
+    pool.emplace_back(guarded([&]() {
+        // The run at the end of the last block written, which may continue
+        // into the next block
+        char pendingChar{0};
+        std::size_t pendingCount{0};
+        bool prevRunDigit{false};
+        auto writeChars = [&](const char* data, std::size_t length) {
+            if (length != 0) {
+                write(data, length);
+                totals.bytesOut += length;
+            }
+        };
+        auto writePending = [&]() {
+            char token[maxETokenLength];
+            writeChars(token, writeEToken(token, pendingChar, pendingCount,
+                prevRunDigit));
+            prevRunDigit = isdigit(static_cast<unsigned char>(pendingChar));
+            pendingCount = 0;
+        };
+
+        PipelineBlock* block;
+        for (std::size_t i{0};
+                fromEncoder[i % numWorkers]->pop(block, failed); i++) {
+            if (block == nullptr) {
+                break;
+            }
+            if (pendingCount != 0 && pendingChar != block->firstChar) {
+                writePending();
+            }
+            pendingChar = block->firstChar;
+            pendingCount += block->firstCount;
+            if (block->lastCount != 0) {
+                writePending();
+                writeChars(block->body.data(), block->body.size());
+                prevRunDigit = block->bodyEndDigit;
+                pendingChar = block->lastChar;
+                pendingCount = block->lastCount;
+            }
+            if (!freeBlocks.push(block, failed)) {
+                return;
+            }
+        }
+        if (pendingCount != 0 && !failed.load(std::memory_order_relaxed)) {
+            writePending();
+        }
+    }));
+
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    return totals;
+}
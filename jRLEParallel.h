@@ -0,0 +1,106 @@
+/**
+ * Multithreaded run-length encoding for jRLE.
+ *
+ * Encoding is independent between runs, except for #-case c: a token
+ * following a run of digits must be marked with a '#'. The input is split
+ * into one chunk per thread, with each split moved forward to the end of the
+ * run it falls in, so no run spans two chunks. Each chunk is then encoded
+ * on its own thread, knowing only whether the char before it is a digit.
+ * Stitching the chunks back together is a plain concatenation, and the
+ * result is identical to that of encode().
+ *
+ * For example, to encode a string on 8 threads:
+ * OutputBuffer out;
+ * encodeParallel(text, out, 8);
+ *
+ * Input that is not all in memory at once, such as a pipe, can instead be
+ * encoded with encodePipelined(), which overlaps reading the input, encoding
+ * it and writing the result. A reader thread reads blocks of input into a
+ * fixed pool of buffers, encoder threads encode them, and a writer thread
+ * writes the encoded blocks in order and returns their buffers to the pool.
+ * The threads pass blocks through bounded, lock-free queues, so memory use
+ * is bounded by the pool, and a stalled stage holds up the others only once
+ * the queues between them fill. Runs spanning two blocks are joined by the
+ * writer.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_PARALLEL_H
+#define JRLE_PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string_view>
+
+#include "jRLECodec.h"
+#include "jRLEStream.h"
+
+
+/**
+ * The smallest chunk of input worth encoding on its own thread.
+ * Smaller inputs are encoded on fewer threads.
+ */
+constexpr std::size_t minParallelChunkSize = 1 << 16;
+
+
+/**
+ * The default size in bytes of the blocks read by encodePipelined()
+ */
+constexpr std::size_t defaultPipelineBlockSize = 1 << 20;
+
+
+/**
+ * Run-length encode a string on multiple threads, writing the result to the
+ * end of an OutputBuffer.
+ *
+ * @param in the unencoded text to encode
+ * @param out the buffer to append the encoded text to
+ * @param threads the maximum number of threads to use.
+ *                0 uses one thread per hardware thread.
+ */
+void encodeParallel(std::string_view in, OutputBuffer& out,
+    unsigned threads = 0);
+
+
+/**
+ * Run-length encode a string on multiple threads, writing the result to an
+ * ostream.
+ *
+ * @param in the unencoded text to encode
+ * @param out the std::ostream to write the encoded text to
+ * @param threads the maximum number of threads to use.
+ *                0 uses one thread per hardware thread.
+ * @return the number of encoded bytes written
+ * @throw std::ios_base::failure if the output stream could not be written
+ */
+std::size_t encodeParallel(std::string_view in, std::ostream& out,
+    unsigned threads = 0);
+
+
+
+/**
+ * Run-length encode input read in blocks, writing the result in blocks, with
+ * reading, encoding and writing all overlapped on their own threads.
+ * The result is identical to that of encode() on the whole input.
+ *
+ * @param read function reading the next block of input into the space
+ *             given, returning the number of bytes read, or 0 at the end of
+ *             the input. Called on the reader thread only.
+ * @param write function writing a block of encoded text. Called on the
+ *              writer thread only.
+ * @param threads the number of encoder threads to use.
+ *                0 uses one thread per hardware thread.
+ * @param blockSize the size in bytes of the blocks of input to read
+ * @return the number of bytes read and written
+ * @throw any exception thrown by read or write, after stopping all threads
+ */
+StreamTotals encodePipelined(
+    const std::function<std::size_t(char*, std::size_t)>& read,
+    const std::function<void(const char*, std::size_t)>& write,
+    unsigned threads = 0,
+    std::size_t blockSize = defaultPipelineBlockSize);
+
+#endif
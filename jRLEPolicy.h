@@ -0,0 +1,868 @@
+/**
+ * Run-length en/decoding of text, specialized at compile time for variants
+ * of the jRLE format.
+ *
+ * BasicRLE<Policy> implements the text format for any policy: a struct
+ * declaring, as static constexpr members:
+ * - marker: the char used in place of '#', to mark long sequences (#-case a)
+ *   and runs of count digits (#-case c), and to escape itself (#-case b)
+ * - longThreshold: the longest run written without the marker. Must be less
+ *   than radix, so that short counts are a single digit.
+ * - radix: the base char counts are written in, from 2 to 36. Digits above
+ *   9 are the lowercase letters, which are then treated as digits too.
+ * - inputHasDigits: false if unencoded text never contains count digits
+ * - inputHasMarkers: false if unencoded text never contains the marker
+ *
+ * Declaring that the unencoded text contains no digits or markers removes
+ * the checks for #-cases b and c from the en/decoding loops. Encoding text
+ * that breaks these guarantees produces text that cannot be decoded, and
+ * decoding text that could only have come from such text throws.
+ *
+ * For example, to encode text known to consist only of uppercase letters:
+ * struct UppercasePolicy : DefaultRLEPolicy {
+ *     static constexpr bool inputHasDigits = false;
+ *     static constexpr bool inputHasMarkers = false;
+ * };
+ * OutputBuffer encoded;
+ * BasicRLE<UppercasePolicy>::encode(text, encoded);
+ *
+ * DefaultRLE, or BasicRLE<DefaultRLEPolicy>, is the format written by
+ * encode() and encodeTokens(), and the codec in jRLECodec.h is implemented
+ * with it.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_POLICY_H
+#define JRLE_POLICY_H
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "jRLECodec.h"
+#include "jRLEScan.h"
+
+
+/**
+ * The policy of the standard jRLE format: '#' markers, decimal counts, and
+ * long sequences of 10 or more chars, for text that may contain anything.
+ */
+struct DefaultRLEPolicy {
+    static constexpr char marker = '#';
+    static constexpr std::size_t longThreshold = 9;
+    static constexpr unsigned radix = 10;
+    static constexpr bool inputHasDigits = true;
+    static constexpr bool inputHasMarkers = true;
+};
+
+
+/**
+ * Throw an exception describing invalid encoded text.
+ *
+ * @param reason description of the error
+ * @param position the position of the invalid char in the encoded text
+ * @throw std::invalid_argument always
+ */
+[[noreturn]] inline void invalidEncoding(const char* reason,
+        std::size_t position) {
+    throw std::invalid_argument("Invalid encoded sequence. "
+        + std::string(reason) + " at position " + std::to_string(position));
+}
+
+
+/**
+ * Run-length en/decoding of text in the format described by a policy.
+ * See the top of this file for the members a policy must declare.
+ */
+template <typename Policy>
+class BasicRLE {
+public:
+    static_assert(Policy::radix >= 2 && Policy::radix <= 36,
+        "Counts must be written in a radix from 2 to 36");
+    static_assert(Policy::longThreshold < Policy::radix,
+        "Runs written without a marker must have a single digit count");
+
+    /**
+     * The longest possible eToken: a marker, every digit of the largest
+     * count, the token char and a marker escaping it.
+     */
+    static constexpr std::size_t maxETokenLength = [] {
+        std::size_t digits{1};
+        for (std::size_t count = std::numeric_limits<std::size_t>::max();
+                count >= Policy::radix; count /= Policy::radix) {
+            digits++;
+        }
+        return digits + 3;
+    }();
+
+    /**
+     * @param c the char to classify
+     * @return true if c is a digit of a char count
+     */
+    static constexpr bool isCountDigit(char c) {
+        return digitValues[static_cast<unsigned char>(c)] >= 0;
+    }
+
+    /**
+     * Calculate the length of the eToken for a single run of chars, without
+     * writing it.
+     *
+     * @param c the char the run consists of
+     * @param count the number of chars in the run. Must be at least 1.
+     * @param prevRunDigit whether the previous run consisted of count digits
+     * @return the number of chars writeEToken() would write
+     */
+    static std::size_t eTokenLength(char c, std::size_t count,
+            bool prevRunDigit) {
+        // The token-defining char, and a marker for #-case a or c
+        std::size_t length = 1 + (count > Policy::longThreshold
+            || (Policy::inputHasDigits && prevRunDigit));
+        // A marker for #-case b
+        if constexpr (Policy::inputHasMarkers) {
+            length += c == Policy::marker;
+        }
+        // The digits of the char count
+        length++;
+        while (count >= Policy::radix) {
+            count /= Policy::radix;
+            length++;
+        }
+        return length;
+    }
+
+    /**
+     * Write the eToken for a single run of chars.
+     *
+     * @param out pointer to space for at least eTokenLength(c, count,
+     *            prevRunDigit) chars. maxETokenLength is always enough.
+     * @param c the char the run consists of
+     * @param count the number of chars in the run. Must be at least 1.
+     * @param prevRunDigit whether the previous run consisted of count digits
+     * @return the number of chars written to out
+     */
+    static std::size_t writeEToken(char* out, char c, std::size_t count,
+            bool prevRunDigit) {
+        char* pos = out;
+
+        // #-case a OR #-case c (or both)
+        if (count > Policy::longThreshold
+                || (Policy::inputHasDigits && prevRunDigit)) {
+            *pos++ = Policy::marker;
+        }
+
+        // Write the char count, followed by the token-defining char.
+        // Most counts are one or two digits, so skip the general conversion.
+        if (count < Policy::radix) {
+            *pos++ = digitChars[count];
+        } else if (count < Policy::radix * Policy::radix) {
+            std::memcpy(pos, &digitPairs[2 * count], 2);
+            pos += 2;
+        } else {
+            // Write two digits at a time, from the last
+            constexpr std::size_t pairRadix = Policy::radix * Policy::radix;
+            std::size_t numDigits{3};
+            for (std::size_t rest = count / pairRadix / Policy::radix;
+                    rest != 0; rest /= Policy::radix) {
+                numDigits++;
+            }
+            pos += numDigits;
+            char* digit = pos;
+            while (count >= pairRadix) {
+                digit -= 2;
+                std::memcpy(digit, &digitPairs[2 * (count % pairRadix)], 2);
+                count /= pairRadix;
+            }
+            if (count >= Policy::radix) {
+                std::memcpy(digit - 2, &digitPairs[2 * count], 2);
+            } else {
+                digit[-1] = digitChars[count];
+            }
+        }
+        *pos++ = c;
+
+        // #-case b
+        if constexpr (Policy::inputHasMarkers) {
+            if (c == Policy::marker) {
+                *pos++ = Policy::marker;
+            }
+        }
+
+        return pos - out;
+    }
+
+    /**
+     * Calculate the exact length of a string once run-length encoded,
+     * without encoding it.
+     *
+     * @param in the unencoded text to measure
+     * @param prevRunDigit whether the text before in ended with a run of
+     *                     count digits
+     * @return the number of chars in the encoded text
+     */
+    static std::size_t encodedLength(std::string_view in,
+            bool prevRunDigit = false) {
+        const char* pos = in.data();
+        const char* end = pos + in.size();
+        std::size_t total{0};
+
+        while (pos < end) {
+            char c = *pos;
+            const char* runEnd = findRunEnd(pos, end);
+            total += eTokenLength(c, runEnd - pos, prevRunDigit);
+            prevRunDigit = Policy::inputHasDigits && isCountDigit(c);
+            pos = runEnd;
+        }
+
+        return total;
+    }
+
+    /**
+     * Run-length encode a string in a single pass, into a caller-supplied
+     * span of chars, reporting an error instead of throwing it.
+     *
+     * @param in the unencoded text to encode
+     * @param out pointer to space for the encoded text
+     * @param capacity the number of chars available at out.
+     *                 encodedLength(in) is always enough.
+     * @param prevRunDigit whether the text before in ended with a run of
+     *                     count digits
+     * @param error set to an outputTooSmall error, at the position in in of
+     *              the first run that did not fit, if the encoded text is
+     *              longer than capacity chars. Left unchanged otherwise.
+     * @return the number of chars written to out: every eToken that fit
+     */
+    static std::size_t encodeInto(std::string_view in, char* out,
+            std::size_t capacity, bool prevRunDigit, CodecError& error) {
+        const char* pos = in.data();
+        const char* end = pos + in.size();
+        std::size_t written{0};
+
+        while (pos < end) {
+            // Find the end of the run starting at pos
+            char c = *pos;
+            const char* runEnd = findRunEnd(pos, end);
+            const std::size_t count = runEnd - pos;
+
+            // Only measure the token when it might not fit
+            if (capacity - written < maxETokenLength
+                    && capacity - written
+                        < eTokenLength(c, count, prevRunDigit)) {
+                error = { CodecStatus::outputTooSmall,
+                    "Encoded text exceeds capacity",
+                    static_cast<std::size_t>(pos - in.data()) };
+                break;
+            }
+            written += writeEToken(out + written, c, count, prevRunDigit);
+
+            prevRunDigit = Policy::inputHasDigits && isCountDigit(c);
+            pos = runEnd;
+        }
+
+        return written;
+    }
+
+    /**
+     * Run-length encode a string in a single pass, into a caller-supplied
+     * span of chars.
+     *
+     * @param in the unencoded text to encode
+     * @param out pointer to space for the encoded text
+     * @param capacity the number of chars available at out.
+     *                 encodedLength(in) is always enough.
+     * @param prevRunDigit whether the text before in ended with a run of
+     *                     count digits
+     * @return the number of chars written to out
+     * @throw std::length_error if the encoded text is longer than capacity
+     *        chars
+     */
+    static std::size_t encodeInto(std::string_view in, char* out,
+            std::size_t capacity, bool prevRunDigit = false) {
+        CodecError error;
+        const std::size_t written = encodeInto(in, out, capacity,
+            prevRunDigit, error);
+        if (error.status != CodecStatus::ok) {
+            throw std::length_error("Encoded text exceeds capacity of "
+                + std::to_string(capacity));
+        }
+        return written;
+    }
+
+    /**
+     * Run-length encode a string, writing the result to the end of an
+     * OutputBuffer. Space for the whole result is made exactly once: for
+     * encodedLengthBound() chars if the buffer can hold them, otherwise for
+     * exactly encodedLength() chars.
+     *
+     * @param in the unencoded text to encode
+     * @param out the buffer to append the encoded text to
+     * @param prevRunDigit whether the text before in ended with a run of
+     *                     count digits
+     */
+    static void encode(std::string_view in, OutputBuffer& out,
+            bool prevRunDigit = false) {
+        // Measuring the text costs nearly as much as encoding it, so it is
+        // only done when caller-owned memory may be too small for the bound
+        std::size_t length = encodedLengthBound(in.size());
+        if (!out.growable() && out.capacity() - out.size() < length) {
+            length = encodedLength(in, prevRunDigit);
+        }
+        if (length == 0) {
+            return;
+        }
+        out.commit(encodeInto(in, out.prepare(length), length,
+            prevRunDigit));
+    }
+
+    /**
+     * Read the next run from encoded text, reporting an error instead of
+     * throwing it.
+     *
+     * @param text the encoded text to read
+     * @param pos the position in text to read from, advanced past the run
+     * @param longSeq whether pos lies within a long sequence, updated to
+     *                whether the new position does
+     * @param count set to the number of chars in the run
+     * @param c set to the char the run consists of
+     * @param error set to an invalidEncoding error if the encoded text is
+     *              invalid. Left unchanged otherwise.
+     * @return true if a run was read, false if the end of the text was
+     *         reached or the encoded text is invalid
+     */
+    static bool readRun(std::string_view text, std::size_t& pos,
+            bool& longSeq, std::size_t& count, char& c, CodecError& error) {
+        const std::size_t length = text.size();
+
+        while (pos < length) {
+            char currentChar = text[pos];
+
+            // If the current token is not a long sequence
+            if (!longSeq) {
+                // Start a new long sequence if one is marked
+                if (currentChar == Policy::marker) {
+                    longSeq = true;
+                    pos++;
+                // If current char is a digit, this is a single-char token.
+                } else if (isCountDigit(currentChar)) {
+                    if (pos + 1 == length) {
+                        return invalid(error, "Missing token char", length);
+                    }
+                    count = digitValue(currentChar);
+                    c = text[pos + 1];
+                    pos += 2;
+                    return true;
+                // A char that is not accompanied by a char count is only
+                // allowed as LF, or on EOF.
+                } else if (currentChar == '\n' || pos + 1 == length) {
+                    pos++;
+                } else {
+                    return invalid(error, "Non-digit char", pos);
+                }
+                continue;
+            }
+
+            // The current token is a long sequence. Read its char count,
+            // remembering the value without the last digit, in case the
+            // last digit turns out to be the token char (#-case c).
+            const std::size_t countStart = pos;
+            std::size_t value{0};
+            std::size_t valuePrefix{0};
+            const std::size_t maxValue =
+                std::numeric_limits<std::size_t>::max();
+            while (pos < length && isCountDigit(text[pos])) {
+                std::size_t digit = digitValue(text[pos]);
+                if (value > (maxValue - digit) / Policy::radix) {
+                    return invalid(error, "Char count too large", pos);
+                }
+                valuePrefix = value;
+                value = value * Policy::radix + digit;
+                pos++;
+            }
+            const std::size_t numDigits = pos - countStart;
+
+            // A long sequence of digit chars that ends the text.
+            // The last digit is the token char, all before it the count.
+            if (pos == length) {
+                if (numDigits == 0) {
+                    return false;
+                } else if (numDigits == 1 || !Policy::inputHasDigits) {
+                    return invalid(error, "Missing token char", length);
+                }
+                count = valuePrefix;
+                c = text[pos - 1];
+                return true;
+            }
+
+            currentChar = text[pos];
+            if (currentChar == Policy::marker) {
+                // #-case b
+                if (Policy::inputHasMarkers && pos + 1 < length
+                        && text[pos + 1] == Policy::marker) {
+                    if (numDigits == 0) {
+                        return invalid(error, "Missing char count", pos);
+                    }
+                    count = value;
+                    c = Policy::marker;
+                    // In case #-case a is also present, continue the long
+                    // sequence
+                    pos += 2;
+                    return true;
+                }
+
+                // #-case a and/or #-case c: the marker ends a token whose
+                // last digit is its token char, and starts the next long
+                // sequence. A marker with no digits before it marks a
+                // sequence that has already started, so is ignored.
+                pos++;
+                if (numDigits == 0) {
+                    continue;
+                } else if (numDigits == 1 || !Policy::inputHasDigits) {
+                    return invalid(error, "Missing char count", countStart);
+                }
+                count = valuePrefix;
+                c = text[pos - 2];
+                return true;
+            }
+
+            // #-case a
+            longSeq = false;
+            pos++;
+            if (numDigits != 0) {
+                count = value;
+                c = currentChar;
+                return true;
+            }
+            // Unless current char is EOF with no char count, the count is
+            // missing
+            if (currentChar != '\n') {
+                return invalid(error, "Missing char count", pos - 1);
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Read the next run from encoded text.
+     *
+     * @param text the encoded text to read
+     * @param pos the position in text to read from, advanced past the run
+     * @param longSeq whether pos lies within a long sequence, updated to
+     *                whether the new position does
+     * @param count set to the number of chars in the run
+     * @param c set to the char the run consists of
+     * @return true if a run was read, false if the end of the text was
+     *         reached
+     * @throw std::invalid_argument if the encoded text is invalid
+     */
+    static bool readRun(std::string_view text, std::size_t& pos,
+            bool& longSeq, std::size_t& count, char& c) {
+        CodecError error;
+        if (readRun(text, pos, longSeq, count, c, error)) {
+            return true;
+        }
+        throwIfFailed(error);
+        return false;
+    }
+
+    /**
+     * Pass each run described by run-length encoded text to a consumer, in
+     * order, without decoding the runs. The consumer is called as
+     * consumer(count, c), and may return a bool, where false stops reading
+     * early. Runs before an error are passed to the consumer, so it sees
+     * every run of valid text, and only a prefix of invalid text.
+     *
+     * @param in the encoded text to read
+     * @param consumer called with the char count and char of each run
+     * @param error set to an invalidEncoding error if the encoded text is
+     *              invalid. Left unchanged otherwise.
+     * @return true if every run was read, false if the consumer stopped
+     *         early or the encoded text is invalid
+     */
+    template <typename Consumer>
+    static bool forEachRun(std::string_view in, Consumer&& consumer,
+            CodecError& error) {
+        std::size_t pos{0};
+        bool longSeq{false};
+        std::size_t count;
+        char c;
+
+        while (readRun(in, pos, longSeq, count, c, error)) {
+            if constexpr (std::is_same_v<
+                    decltype(consumer(count, c)), bool>) {
+                if (!consumer(count, c)) {
+                    return false;
+                }
+            } else {
+                consumer(count, c);
+            }
+        }
+
+        return error.status == CodecStatus::ok;
+    }
+
+    /**
+     * Pass each run described by run-length encoded text to a consumer, in
+     * order, without decoding the runs. The consumer is called as
+     * consumer(count, c), and may return a bool, where false stops reading
+     * early.
+     *
+     * @param in the encoded text to read
+     * @param consumer called with the char count and char of each run
+     * @return true if every run was read, false if the consumer stopped
+     *         early
+     * @throw std::invalid_argument if the encoded text is invalid, once
+     *        the runs before the error have been passed to the consumer
+     */
+    template <typename Consumer>
+    static bool forEachRun(std::string_view in, Consumer&& consumer) {
+        CodecError error;
+        const bool finished = forEachRun(in, consumer, error);
+        throwIfFailed(error);
+        return finished;
+    }
+
+    /**
+     * Calculate the exact length of run-length encoded text once decoded,
+     * without decoding it, reporting an error instead of throwing it.
+     *
+     * @param in the encoded text to measure
+     * @param error set to an invalidEncoding error if the encoded text is
+     *              invalid. Left unchanged otherwise.
+     * @return the number of chars in the decoded text, or 0 if it is
+     *         invalid
+     */
+    static std::size_t decodedLength(std::string_view in,
+            CodecError& error) {
+        std::size_t pos{0};
+        bool longSeq{false};
+        std::size_t total{0};
+        std::size_t count;
+        char c;
+
+        while (readRun(in, pos, longSeq, count, c, error)) {
+            if (count > std::numeric_limits<std::size_t>::max() - total) {
+                invalid(error, "Decoded length too large", pos);
+                break;
+            }
+            total += count;
+        }
+
+        return error.status == CodecStatus::ok ? total : 0;
+    }
+
+    /**
+     * Calculate the exact length of run-length encoded text once decoded,
+     * without decoding it.
+     *
+     * @param in the encoded text to measure
+     * @return the number of chars in the decoded text
+     * @throw std::invalid_argument if the encoded text is invalid
+     */
+    static std::size_t decodedLength(std::string_view in) {
+        CodecError error;
+        const std::size_t total = decodedLength(in, error);
+        throwIfFailed(error);
+        return total;
+    }
+
+    /**
+     * Run-length decode a string into a caller-supplied span of chars,
+     * reporting an error instead of throwing it.
+     *
+     * @param in the encoded text to decode
+     * @param out pointer to space for the decoded text
+     * @param capacity the number of chars available at out
+     * @param error set to an invalidEncoding error if the encoded text is
+     *              invalid, or an outputTooSmall error if it decodes to
+     *              more than capacity chars. Left unchanged otherwise.
+     * @return the number of chars written to out: every run decoded before
+     *         any error
+     */
+    static std::size_t decodeInto(std::string_view in, char* out,
+            std::size_t capacity, CodecError& error) {
+        std::size_t pos{0};
+        bool longSeq{false};
+        std::size_t written{0};
+        std::size_t count;
+        char c;
+
+        while (readRun(in, pos, longSeq, count, c, error)) {
+            if (count > capacity - written) {
+                error = { CodecStatus::outputTooSmall,
+                    "Decoded text too long", pos };
+                break;
+            }
+            std::memset(out + written, c, count);
+            written += count;
+        }
+
+        return written;
+    }
+
+    /**
+     * Run-length decode a string into a caller-supplied span of chars.
+     *
+     * @param in the encoded text to decode
+     * @param out pointer to space for the decoded text
+     * @param capacity the number of chars available at out
+     * @return the number of chars written to out
+     * @throw std::invalid_argument if the encoded text is invalid, or
+     *        decodes to more than capacity chars
+     */
+    static std::size_t decodeInto(std::string_view in, char* out,
+            std::size_t capacity) {
+        CodecError error;
+        const std::size_t written = decodeInto(in, out, capacity, error);
+        throwIfFailed(error);
+        return written;
+    }
+
+    /**
+     * Check whether run-length encoded text is valid, without decoding it.
+     * Accepts exactly the text that decodedLength() accepts, but with a
+     * table-driven state machine that does a single table lookup per char
+     * and no branches on the text, so it is not slowed down by short runs.
+     * Invalid text, and text with very long counts, is checked again with
+     * readRun() to describe the error exactly.
+     *
+     * @param in the encoded text to check
+     * @param error set to an invalidEncoding error if the encoded text is
+     *              invalid. Left unchanged otherwise.
+     * @return true if the encoded text is valid
+     */
+    static bool validate(std::string_view in, CodecError& error) {
+        const unsigned char* pos =
+            reinterpret_cast<const unsigned char*>(in.data());
+        const unsigned char* end = pos + in.size();
+        const unsigned char* table = validationTable();
+        std::size_t state = outsideState;
+
+        // Check for a failure between blocks rather than after every char
+        constexpr std::ptrdiff_t blockLength = 64;
+        while (pos != end && state != recheckState) {
+            const unsigned char* blockEnd =
+                end - pos > blockLength ? pos + blockLength : end;
+            for (; pos != blockEnd; pos++) {
+                state = table[state * 256 + *pos];
+            }
+        }
+
+        // Every count is below shortCountLimit, and there is at most one
+        // run per char, so the decoded length cannot overflow
+        if (acceptingStates[state]
+                && in.size() <= std::numeric_limits<std::size_t>::max()
+                    / shortCountLimit) {
+            return true;
+        }
+        decodedLength(in, error);
+        return error.status == CodecStatus::ok;
+    }
+
+    /**
+     * Run-length decode a string, writing the result to the end of an
+     * OutputBuffer. Space for the whole result is made exactly once.
+     *
+     * @param in the encoded text to decode
+     * @param out the buffer to append the decoded text to. If the encoded
+     *            text is invalid, the buffer is left unchanged.
+     * @throw std::invalid_argument if the encoded text is invalid
+     */
+    static void decode(std::string_view in, OutputBuffer& out) {
+        const std::size_t length = decodedLength(in);
+        if (length == 0) {
+            return;
+        }
+        out.commit(decodeInto(in, out.prepare(length), length));
+    }
+
+private:
+    // The char of each digit value, then the value of each char, or -1 for
+    // chars that are not count digits
+    static constexpr char digitChars[] =
+        "0123456789abcdefghijklmnopqrstuvwxyz";
+    static constexpr std::array<signed char, 256> digitValues = [] {
+        std::array<signed char, 256> values{};
+        for (signed char& value : values) {
+            value = -1;
+        }
+        for (unsigned digit{0}; digit < Policy::radix; digit++) {
+            values[static_cast<unsigned char>(digitChars[digit])] =
+                static_cast<signed char>(digit);
+        }
+        return values;
+    }();
+
+    // The two digit chars of every value below radix * radix, in order
+    static constexpr std::array<char, 2 * Policy::radix * Policy::radix>
+            digitPairs = [] {
+        std::array<char, 2 * Policy::radix * Policy::radix> pairs{};
+        for (unsigned value{0}; value < Policy::radix * Policy::radix;
+                value++) {
+            pairs[2 * value] = digitChars[value / Policy::radix];
+            pairs[2 * value + 1] = digitChars[value % Policy::radix];
+        }
+        return pairs;
+    }();
+
+    static_assert(
+        digitValues[static_cast<unsigned char>(Policy::marker)] < 0,
+        "The marker must not be a count digit");
+
+    // The most count digits the validation state machine follows. Every
+    // count of this many digits is below shortCountLimit, the square root
+    // of the largest size_t, and a count with more is checked by readRun().
+    static constexpr std::size_t shortCountLimit =
+        std::size_t{1} << (std::numeric_limits<std::size_t>::digits / 2);
+    static constexpr std::size_t shortCountDigits = [] {
+        std::size_t digits{0};
+        for (std::size_t limit = shortCountLimit / Policy::radix; limit != 0;
+                limit /= Policy::radix) {
+            digits++;
+        }
+        return digits;
+    }();
+
+    // The states of the validation state machine, each mirroring a point in
+    // readRun():
+    // - outside: between tokens, outside a long sequence
+    // - afterDigit: after the count of a single-char token
+    // - stray: after a char with no count, only allowed last
+    // - count + n: within a long sequence, after n count digits
+    // - marker + n: after a marker following n (at most 2) count digits,
+    //   which could start #-case b
+    // - recheck: the text is invalid, or must be checked by readRun()
+    static constexpr std::size_t outsideState = 0;
+    static constexpr std::size_t afterDigitState = 1;
+    static constexpr std::size_t strayState = 2;
+    static constexpr std::size_t countState = 3;
+    static constexpr std::size_t markerState = countState
+        + shortCountDigits + 1;
+    static constexpr std::size_t recheckState = markerState + 3;
+    static constexpr std::size_t validationStates = recheckState + 1;
+
+    /**
+     * @param state a state of the validation state machine
+     * @param c the next char of the encoded text
+     * @return the state after c
+     */
+    static constexpr std::size_t nextValidationState(std::size_t state,
+            char c) {
+        const bool digit = isCountDigit(c);
+        const bool marker = c == Policy::marker;
+        if (state == outsideState) {
+            return marker ? countState
+                : digit ? afterDigitState
+                : c == '\n' ? outsideState
+                : strayState;
+        } else if (state == afterDigitState) {
+            return outsideState;
+        } else if (state >= countState && state < markerState) {
+            const std::size_t digits = state - countState;
+            if (digit) {
+                return digits < shortCountDigits ? state + 1 : recheckState;
+            } else if (marker && Policy::inputHasMarkers) {
+                return markerState + (digits < 2 ? digits : 2);
+            } else if (marker) {
+                return digits == 0 || (digits >= 2 && Policy::inputHasDigits)
+                    ? countState : recheckState;
+            }
+            return digits != 0 || c == '\n' ? outsideState : recheckState;
+        } else if (state == markerState) {
+            return marker ? recheckState
+                : nextValidationState(countState, c);
+        } else if (state == markerState + 1) {
+            return marker ? countState : recheckState;
+        } else if (state == markerState + 2) {
+            return marker ? countState
+                : Policy::inputHasDigits ? nextValidationState(countState, c)
+                : recheckState;
+        }
+        return recheckState;
+    }
+
+    /**
+     * @return the state of the validation state machine after each char,
+     *         for each state
+     */
+    static const unsigned char* validationTable() {
+        static constexpr std::array<unsigned char, validationStates * 256>
+                table = [] {
+            std::array<unsigned char, validationStates * 256> next{};
+            for (std::size_t state{0}; state < validationStates; state++) {
+                for (std::size_t c{0}; c < 256; c++) {
+                    next[state * 256 + c] = static_cast<unsigned char>(
+                        nextValidationState(state, static_cast<char>(c)));
+                }
+            }
+            return next;
+        }();
+        return table.data();
+    }
+
+    // Whether the encoded text is valid if it ends in each state
+    static constexpr std::array<bool, validationStates> acceptingStates = [] {
+        std::array<bool, validationStates> accepting{};
+        accepting[outsideState] = true;
+        accepting[strayState] = true;
+        accepting[countState] = true;
+        for (std::size_t digits{2}; digits <= shortCountDigits; digits++) {
+            accepting[countState + digits] = Policy::inputHasDigits;
+        }
+        accepting[markerState] = true;
+        accepting[markerState + 2] = Policy::inputHasDigits;
+        return accepting;
+    }();
+
+    static_assert(validationStates <= 256,
+        "Validation states must fit in the table");
+
+    /**
+     * Report invalid encoded text.
+     *
+     * @param error set to an invalidEncoding error
+     * @param reason description of the error
+     * @param position the position of the invalid char in the encoded text
+     * @return false, for readRun() to return
+     */
+    static bool invalid(CodecError& error, const char* reason,
+            std::size_t position) {
+        error = { CodecStatus::invalidEncoding, reason, position };
+        return false;
+    }
+
+    /**
+     * Throw the error reported by a decoder, if there is one.
+     *
+     * @param error the error reported
+     * @throw std::invalid_argument if error has a status other than ok
+     */
+    static void throwIfFailed(const CodecError& error) {
+        if (error.status != CodecStatus::ok) {
+            invalidEncoding(error.reason, error.position);
+        }
+    }
+
+    /**
+     * @param c a count digit
+     * @return the value of c
+     */
+    static std::size_t digitValue(char c) {
+        return static_cast<std::size_t>(
+            digitValues[static_cast<unsigned char>(c)]);
+    }
+};
+
+
+/**
+ * The standard jRLE format.
+ */
+using DefaultRLE = BasicRLE<DefaultRLEPolicy>;
+
+#endif
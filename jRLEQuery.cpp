@@ -0,0 +1,195 @@
+/**
+ * Queries on plain run-length encoded text, answered from its runs.
+ * See jRLEQuery.h for usage.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLEQuery.h"
+#include "jRLEAppend.h"
+#include "jRLEView.h"
+
+#include <algorithm>
+#include <limits>
+
+
+/**
+ * Count the occurrences of a char in the decoded text of run-length encoded
+ * text, without decoding it.
+ *
+ * @param encoded the encoded text to search
+ * @param c the char to count
+ * @return the number of chars in the decoded text equal to c
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+std::size_t countByte(std::string_view encoded, char c) {
+    std::size_t total{0};
+    forEachRun(encoded, [&](std::size_t count, char runChar) {
+        if (runChar == c) {
+            total += count;
+        }
+    });
+    return total;
+}
+
+
+/**
+ * Find the first occurrence of a char in the decoded text of run-length
+ * encoded text, without decoding it. Reading stops at the run containing
+ * it, so the encoded text after that run is not checked.
+ *
+ * @param encoded the encoded text to search
+ * @param c the char to find
+ * @return the position in the decoded text of the first char equal to c,
+ *         or std::string_view::npos if there is none
+ * @throw std::invalid_argument if the encoded text is invalid before the
+ *        first occurrence of c
+ */
+std::size_t findByte(std::string_view encoded, char c) {
+    std::size_t position{0};
+    const bool found = !forEachRun(encoded,
+        [&](std::size_t count, char runChar) {
+            if (runChar == c && count != 0) {
+                return false;
+            }
+            position += count;
+            return true;
+        });
+    return found ? position : std::string_view::npos;
+}
+
+
+/**
+ * Read the next run with at least one char from encoded text, skipping any
+ * with none.
+ *
+ * @param reader the reader to read from
+ * @param count set to the number of chars in the run, or 0 at the end of
+ *              the text
+ * @param c set to the char the run consists of
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+static void nextNonEmptyRun(EncodedRunReader& reader, std::size_t& count,
+        char& c) {
+    count = 0;
+    while (count == 0 && reader.next(count, c)) {
+    }
+}
+
+
+/**
+ * Find the first position at which the decoded texts of two run-length
+ * encoded texts differ, without decoding either. Reading stops at the run
+ * containing it, so the encoded text after that run is not checked.
+ *
+ * @param a the first encoded text
+ * @param b the second encoded text
+ * @return the position of the first char that differs, or the length of
+ *         the shorter decoded text if it is a prefix of the longer, or
+ *         std::string_view::npos if the decoded texts are equal
+ * @throw std::invalid_argument if either encoded text is invalid before the
+ *        first difference
+ */
+std::size_t firstDifference(std::string_view a, std::string_view b) {
+    EncodedRunReader readerA{ a };
+    EncodedRunReader readerB{ b };
+    // The chars left in the current run of each text
+    std::size_t countA{0};
+    std::size_t countB{0};
+    char charA{0};
+    char charB{0};
+    std::size_t position{0};
+
+    // Runs may be split differently in each text, so step through both by
+    // the shorter of their current runs
+    while (true) {
+        if (countA == 0) {
+            nextNonEmptyRun(readerA, countA, charA);
+        }
+        if (countB == 0) {
+            nextNonEmptyRun(readerB, countB, charB);
+        }
+        if (countA == 0 || countB == 0) {
+            return countA == countB ? std::string_view::npos : position;
+        } else if (charA != charB) {
+            return position;
+        }
+        const std::size_t step = std::min(countA, countB);
+        position += step;
+        countA -= step;
+        countB -= step;
+    }
+}
+
+
+/**
+ * Check whether two run-length encoded texts decode to the same text,
+ * without decoding either.
+ *
+ * @param a the first encoded text
+ * @param b the second encoded text
+ * @return true if the decoded texts are equal
+ * @throw std::invalid_argument if either encoded text is invalid before the
+ *        first difference
+ */
+bool encodedEqual(std::string_view a, std::string_view b) {
+    return firstDifference(a, b) == std::string_view::npos;
+}
+
+
+/**
+ * Join two plain run-length encoded texts, writing the encoding of their
+ * concatenated decoded texts to the end of an OutputBuffer, without
+ * decoding either. If b starts with the char that a ends with, the two
+ * runs are merged into a single eToken, and otherwise the first eToken of
+ * b gains or loses its marker for #-case c as the end of a requires. The
+ * rest of both texts is copied as it is, so the result is identical to
+ * encoding the concatenated text whenever a and b are as written by
+ * encode().
+ *
+ * @param a the encoded text to come first
+ * @param b the encoded text to come second
+ * @param out the buffer to append the joined encoded text to. If either
+ *            encoded text is invalid, the buffer is left unchanged.
+ * @throw std::invalid_argument if either encoded text is invalid
+ */
+void concatenateEncoded(std::string_view a, std::string_view b,
+        OutputBuffer& out) {
+    // The rest of b is copied unread, so must be checked first
+    CodecError error;
+    if (!validateEncoded(b, error)) {
+        invalidEncoding(error.reason, error.position);
+    }
+    const AppendState end = scanAppendState(a);
+
+    // Find the first run of b with chars, and where its eToken ends
+    EncodedRunReader reader{ b };
+    std::size_t count{0};
+    char c{0};
+    while (count == 0 && reader.next(count, c)) {
+    }
+    if (count == 0) {
+        out.append(a);
+        return;
+    } else if (end.encodedLength == 0) {
+        out.append(b);
+        return;
+    }
+    const std::size_t firstEnd = eTokenEnd(b, reader.position(),
+        reader.inLongSeq(), c);
+
+    // Merge the runs either side of the seam, unless the count would
+    // overflow, in which case they are left as two eTokens
+    if (c == end.lastChar && end.lastCount != 0
+            && count <= std::numeric_limits<std::size_t>::max()
+                - end.lastCount) {
+        out.append(a.substr(0, end.lastTokenOffset));
+        out.commit(writeEToken(out.prepare(maxETokenLength), c,
+            end.lastCount + count, end.prevRunDigit));
+    } else {
+        out.append(a.substr(0, end.encodedLength));
+        out.commit(writeEToken(out.prepare(maxETokenLength), c, count,
+            DefaultRLE::isCountDigit(end.lastChar)));
+    }
+    out.append(b.substr(firstEnd));
+}
@@ -0,0 +1,106 @@
+/**
+ * Queries on plain run-length encoded text, answered from its runs without
+ * decoding it, for jRLE.
+ *
+ * Each query reads the runs of the encoded text with an EncodedRunReader,
+ * or forEachRun(), and does constant work per run however long it is, so
+ * costs time in the length of the encoded text rather than the decoded
+ * text. The decoded length of encoded text is given by decodedLength().
+ *
+ * Encoded texts are compared by the text they decode to, so texts that
+ * split a run into several eTokens still compare equal to those that do
+ * not. concatenateEncoded() joins two encoded texts without decoding
+ * either, rewriting only the eTokens either side of the seam.
+ *
+ * For example, to count the lines in encoded text:
+ * std::size_t lines = countByte(encoded, '\n');
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_QUERY_H
+#define JRLE_QUERY_H
+
+#include <cstddef>
+#include <string_view>
+
+#include "jRLECodec.h"
+
+
+/**
+ * Count the occurrences of a char in the decoded text of run-length encoded
+ * text, without decoding it.
+ *
+ * @param encoded the encoded text to search
+ * @param c the char to count
+ * @return the number of chars in the decoded text equal to c
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+std::size_t countByte(std::string_view encoded, char c);
+
+
+/**
+ * Find the first occurrence of a char in the decoded text of run-length
+ * encoded text, without decoding it. Reading stops at the run containing
+ * it, so the encoded text after that run is not checked.
+ *
+ * @param encoded the encoded text to search
+ * @param c the char to find
+ * @return the position in the decoded text of the first char equal to c,
+ *         or std::string_view::npos if there is none
+ * @throw std::invalid_argument if the encoded text is invalid before the
+ *        first occurrence of c
+ */
+std::size_t findByte(std::string_view encoded, char c);
+
+
+/**
+ * Find the first position at which the decoded texts of two run-length
+ * encoded texts differ, without decoding either. Reading stops at the run
+ * containing it, so the encoded text after that run is not checked.
+ *
+ * @param a the first encoded text
+ * @param b the second encoded text
+ * @return the position of the first char that differs, or the length of
+ *         the shorter decoded text if it is a prefix of the longer, or
+ *         std::string_view::npos if the decoded texts are equal
+ * @throw std::invalid_argument if either encoded text is invalid before the
+ *        first difference
+ */
+std::size_t firstDifference(std::string_view a, std::string_view b);
+
+
+/**
+ * Check whether two run-length encoded texts decode to the same text,
+ * without decoding either.
+ *
+ * @param a the first encoded text
+ * @param b the second encoded text
+ * @return true if the decoded texts are equal
+ * @throw std::invalid_argument if either encoded text is invalid before the
+ *        first difference
+ */
+bool encodedEqual(std::string_view a, std::string_view b);
+
+
+/**
+ * Join two plain run-length encoded texts, writing the encoding of their
+ * concatenated decoded texts to the end of an OutputBuffer, without
+ * decoding either. If b starts with the char that a ends with, the two
+ * runs are merged into a single eToken, and otherwise the first eToken of
+ * b gains or loses its marker for #-case c as the end of a requires. The
+ * rest of both texts is copied as it is, so the result is identical to
+ * encoding the concatenated text whenever a and b are as written by
+ * encode().
+ *
+ * @param a the encoded text to come first
+ * @param b the encoded text to come second
+ * @param out the buffer to append the joined encoded text to. If either
+ *            encoded text is invalid, the buffer is left unchanged.
+ * @throw std::invalid_argument if either encoded text is invalid
+ */
+void concatenateEncoded(std::string_view a, std::string_view b,
+    OutputBuffer& out);
+
+#endif
@@ -0,0 +1,235 @@
+/**
+ * Vectorized run boundary detection for jRLE.
+ * See jRLEScan.h for usage.
+ *
+ * Each implementation broadcasts the run char across a vector register,
+ * compares a block of input against it, and collapses the result into a
+ * bit mask. The first zero bit in the mask is the end of the run.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLEScan.h"
+
+#include <cstdint>
+
+// SSE2 is the baseline for the vectorized x86 implementations
+#if defined(__SSE2__) || defined(_M_X64) \
+        || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JRLE_SCAN_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define JRLE_SCAN_NEON
+#include <arm_neon.h>
+#endif
+
+// GCC and Clang only allow AVX2 intrinsics in functions marked for AVX2.
+// MSVC allows them anywhere.
+#if defined(JRLE_SCAN_X86) && (defined(__GNUC__) || defined(__clang__))
+#define JRLE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define JRLE_TARGET_AVX2
+#endif
+
+
+/**
+ * @param mask a non-zero bit mask
+ * @return the index of the lowest set bit in mask
+ */
+static inline unsigned lowestSetBit(std::uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+
+/**
+ * Portable implementation of findRunEnd(), comparing one char at a time.
+ */
+static const char* findRunEndScalar(const char* begin, const char* end) {
+    const char c = *begin;
+    const char* pos = begin + 1;
+    while (pos < end && *pos == c) {
+        pos++;
+    }
+    return pos;
+}
+
+
+#if defined(JRLE_SCAN_X86)
+/**
+ * SSE2 implementation of findRunEnd(), comparing 16 chars at a time.
+ */
+static const char* findRunEndSSE2(const char* begin, const char* end) {
+    const __m128i runChar = _mm_set1_epi8(*begin);
+    const char* pos = begin + 1;
+
+    while (end - pos >= 16) {
+        __m128i block = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(pos));
+        // One bit per char, set where the char matches the run
+        std::uint32_t mask = static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(block, runChar)));
+        if (mask != 0xFFFF) {
+            return pos + lowestSetBit(~mask);
+        }
+        pos += 16;
+    }
+
+    // Finish the last partial block
+    while (pos < end && *pos == *begin) {
+        pos++;
+    }
+    return pos;
+}
+
+
+/**
+ * AVX2 implementation of findRunEnd(), comparing 32 chars at a time.
+ */
+JRLE_TARGET_AVX2
+static const char* findRunEndAVX2(const char* begin, const char* end) {
+    const __m256i runChar = _mm256_set1_epi8(*begin);
+    const char* pos = begin + 1;
+
+    while (end - pos >= 32) {
+        __m256i block = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(pos));
+        // One bit per char, set where the char matches the run
+        std::uint32_t mask = static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, runChar)));
+        if (mask != 0xFFFFFFFF) {
+            return pos + lowestSetBit(~mask);
+        }
+        pos += 32;
+    }
+
+    // Finish the last partial block
+    while (pos < end && *pos == *begin) {
+        pos++;
+    }
+    return pos;
+}
+
+
+/**
+ * @return whether the CPU and operating system support AVX2
+ */
+static bool cpuHasAVX2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    // The OS must save the AVX registers (OSXSAVE and XCR0 bits 1 and 2)
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+
+#if defined(JRLE_SCAN_NEON)
+/**
+ * NEON implementation of findRunEnd(), comparing 16 chars at a time.
+ */
+static const char* findRunEndNEON(const char* begin, const char* end) {
+    const uint8x16_t runChar = vdupq_n_u8(static_cast<std::uint8_t>(*begin));
+    const char* pos = begin + 1;
+
+    while (end - pos >= 16) {
+        uint8x16_t block = vld1q_u8(
+            reinterpret_cast<const std::uint8_t*>(pos));
+        uint8x16_t matches = vceqq_u8(block, runChar);
+        // NEON has no movemask. Narrowing each 16-bit lane by 4 bits packs
+        // the comparison into 4 bits per char, in a single 64-bit mask.
+        std::uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+            vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+        if (mask != ~std::uint64_t{0}) {
+            std::uint64_t mismatches = ~mask;
+#if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long index;
+            _BitScanForward64(&index, mismatches);
+#else
+            unsigned index = static_cast<unsigned>(
+                __builtin_ctzll(mismatches));
+#endif
+            return pos + index / 4;
+        }
+        pos += 16;
+    }
+
+    // Finish the last partial block
+    while (pos < end && *pos == *begin) {
+        pos++;
+    }
+    return pos;
+}
+#endif
+
+
+// A findRunEnd() implementation, and the name to report it by
+struct RunScanner {
+    const char* (*scan)(const char*, const char*);
+    const char* name;
+};
+
+
+/**
+ * Choose the fastest findRunEnd() implementation supported by this CPU.
+ * The choice is made once, on first use.
+ */
+static const RunScanner& runScanner() {
+    static const RunScanner scanner = []() -> RunScanner {
+#if defined(JRLE_SCAN_X86)
+        if (cpuHasAVX2()) {
+            return { findRunEndAVX2, "avx2" };
+        }
+        return { findRunEndSSE2, "sse2" };
+#elif defined(JRLE_SCAN_NEON)
+        return { findRunEndNEON, "neon" };
+#endif
+        return { findRunEndScalar, "scalar" };
+    }();
+    return scanner;
+}
+
+
+/**
+ * Find the end of the run of chars starting at begin.
+ *
+ * @param begin pointer to the first char of the run. Must be before end.
+ * @param end pointer to the char after the last that may be scanned
+ * @return pointer to the first char after begin that differs from *begin,
+ *         or end if there is none
+ */
+const char* findRunEnd(const char* begin, const char* end) {
+    // Most runs in text are short, and are found without a vector load
+    if (end - begin < 2 || begin[1] != begin[0]) {
+        return begin + 1;
+    }
+    return runScanner().scan(begin, end);
+}
+
+
+/**
+ * @return the name of the implementation used by findRunEnd() on this CPU:
+ *         "avx2", "sse2", "neon" or "scalar"
+ */
+const char* runScanBackend() {
+    return runScanner().name;
+}
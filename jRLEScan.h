@@ -0,0 +1,36 @@
+/**
+ * Vectorized run boundary detection for jRLE.
+ *
+ * Finding where each run of chars ends is the core of every encoder in this
+ * program. findRunEnd() compares 16 or 32 chars at a time against the run
+ * char, and jumps straight to the first that differs.
+ *
+ * The fastest implementation supported by the CPU is chosen at runtime:
+ * AVX2 or SSE2 on x86, NEON on ARM, with a portable scalar fallback.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_SCAN_H
+#define JRLE_SCAN_H
+
+
+/**
+ * Find the end of the run of chars starting at begin.
+ *
+ * @param begin pointer to the first char of the run. Must be before end.
+ * @param end pointer to the char after the last that may be scanned
+ * @return pointer to the first char after begin that differs from *begin,
+ *         or end if there is none
+ */
+const char* findRunEnd(const char* begin, const char* end);
+
+
+/**
+ * @return the name of the implementation used by findRunEnd() on this CPU:
+ *         "avx2", "sse2", "neon" or "scalar"
+ */
+const char* runScanBackend();
+
+#endif
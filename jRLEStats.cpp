@@ -0,0 +1,164 @@
+/**
+ * Statistics on run-length en/decoding for jRLE.
+ * See jRLEStats.h for usage.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLEStats.h"
+#include "jRLEPolicy.h"
+#include "jRLEScan.h"
+
+
+/**
+ * Add the counts from another RunStats to these.
+ *
+ * @param other the counts to add
+ */
+void RunStats::merge(const RunStats& other) {
+    runs += other.runs;
+    for (std::size_t i{0}; i < runLengthBuckets; i++) {
+        histogram[i] += other.histogram[i];
+    }
+    longSequences += other.longSequences;
+    markerRuns += other.markerRuns;
+    digitFollowingRuns += other.digitFollowingRuns;
+}
+
+
+/**
+ * Count the pending run, which is known to be complete.
+ */
+void RunCounter::addRun() {
+    std::size_t bucket{0};
+    for (std::size_t count = pendingCount; count > 1; count >>= 1) {
+        bucket++;
+    }
+    totals.runs++;
+    totals.histogram[bucket]++;
+    totals.longSequences += pendingCount > DefaultRLEPolicy::longThreshold;
+    totals.markerRuns += pendingChar == DefaultRLEPolicy::marker;
+    totals.digitFollowingRuns += prevRunDigit;
+    prevRunDigit = DefaultRLE::isCountDigit(pendingChar);
+    pendingCount = 0;
+}
+
+
+/**
+ * Count the runs in the next chunk of unencoded text.
+ *
+ * @param data pointer to the chunk
+ * @param length the number of chars in the chunk
+ */
+void RunCounter::write(const char* data, std::size_t length) {
+    const char* end = data + length;
+    while (data != end) {
+        const char* runEnd = findRunEnd(data, end);
+        if (pendingCount != 0 && *data != pendingChar) {
+            addRun();
+        }
+        pendingChar = *data;
+        pendingCount += runEnd - data;
+        data = runEnd;
+    }
+}
+
+
+/**
+ * Count the final run, and return the totals.
+ *
+ * @return the counts of all runs written
+ */
+RunStats RunCounter::finish() {
+    if (pendingCount != 0) {
+        addRun();
+    }
+    return totals;
+}
+
+
+/**
+ * Add the statistics from another CodecStats to these. Stage times are
+ * summed, and the longer wall time is kept, as for work done at once.
+ *
+ * @param other the statistics to add
+ */
+void CodecStats::merge(const CodecStats& other) {
+    bytesIn += other.bytesIn;
+    bytesOut += other.bytesOut;
+    runs.merge(other.runs);
+    for (std::size_t i{0}; i < stageCount; i++) {
+        stageSeconds[i] += other.stageSeconds[i];
+    }
+    if (other.wallSeconds > wallSeconds) {
+        wallSeconds = other.wallSeconds;
+    }
+}
+
+
+/**
+ * Describe a CodecStats as a report for people, or as a JSON object.
+ * Only histogram buckets with runs in them are included.
+ *
+ * @param stats the statistics to describe
+ * @param json true for a JSON object, false for lines of text
+ * @return the report, ending with a newline
+ */
+std::string formatStats(const CodecStats& stats, bool json) {
+    static const char* const stageNames[stageCount] =
+        { "read", "encode", "decode", "write" };
+    const RunStats& runs = stats.runs;
+    // Each field as a name and its already formatted value
+    auto field = [json](const std::string& name, const std::string& value) {
+        if (json) {
+            return '"' + name + "\": " + value;
+        }
+        // Lists of values start on the next line
+        return name + (value.empty() || value.front() == '\n' ? ":" : ": ")
+            + value;
+    };
+    const std::string separator = json ? ", " : "\n";
+
+    std::string histogram;
+    for (std::size_t i{0}; i < runLengthBuckets; i++) {
+        if (runs.histogram[i] == 0) {
+            continue;
+        }
+        const std::size_t min = std::size_t{1} << i;
+        const std::size_t max = min + (min - 1);
+        if (json) {
+            histogram += std::string(histogram.empty() ? "" : ", ")
+                + "{\"min\": " + std::to_string(min)
+                + ", \"max\": " + std::to_string(max)
+                + ", \"runs\": " + std::to_string(runs.histogram[i]) + '}';
+        } else {
+            histogram += "\n  " + std::to_string(min)
+                + (min == max ? "" : "-" + std::to_string(max))
+                + ": " + std::to_string(runs.histogram[i]);
+        }
+    }
+
+    std::string seconds;
+    for (std::size_t i{0}; i < stageCount; i++) {
+        if (stats.stageSeconds[i] != 0) {
+            seconds += (json ? (seconds.empty() ? "" : ", ") : "\n  ")
+                + field(stageNames[i], std::to_string(stats.stageSeconds[i]));
+        }
+    }
+    seconds += (json ? (seconds.empty() ? "" : ", ") : "\n  ")
+        + field("total", std::to_string(stats.wallSeconds));
+
+    std::string report = (json ? "{" : "")
+        + field("bytesIn", std::to_string(stats.bytesIn)) + separator
+        + field("bytesOut", std::to_string(stats.bytesOut)) + separator
+        + field("runs", std::to_string(runs.runs)) + separator
+        + field("longSequences", std::to_string(runs.longSequences))
+        + separator
+        + field("markerRuns", std::to_string(runs.markerRuns)) + separator
+        + field("digitFollowingRuns",
+            std::to_string(runs.digitFollowingRuns)) + separator
+        + field("runLengthHistogram", json ? '[' + histogram + ']'
+            : histogram) + separator
+        + field("seconds", json ? '{' + seconds + '}' : seconds);
+    return report + (json ? "}\n" : "\n");
+}
@@ -0,0 +1,201 @@
+/**
+ * Statistics on run-length en/decoding for jRLE.
+ *
+ * Whether a text is worth run-length encoding depends on its runs: how many
+ * there are, how long they are, and how many of their eTokens need a '#'.
+ * A RunCounter measures these for unencoded text, in chunks of any size,
+ * and a CodecStats gathers them along with the bytes read and written and
+ * the time spent in each stage of en/decoding.
+ *
+ * For example, to count the runs in a string:
+ * RunCounter counter;
+ * counter.write(text.data(), text.size());
+ * RunStats runs = counter.finish();
+ *
+ * Stage timings are taken with a StageTimer over each stage:
+ * CodecStats stats;
+ * {
+ *     StageTimer timer{ &stats, Stage::encode };
+ *     encode(text, out);
+ * }
+ * std::cout << formatStats(stats, false);
+ *
+ * Building with JRLE_STATS defined as 0 compiles out StageTimer, so that
+ * timed code costs nothing, and removes --stats from the command line.
+ * Runs are only counted when a RunCounter is used, so never slow down the
+ * en/decoders themselves.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_STATS_H
+#define JRLE_STATS_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+// Whether to collect stage timings, and support --stats
+#ifndef JRLE_STATS
+#define JRLE_STATS 1
+#endif
+
+
+/**
+ * The number of buckets in a run length histogram. Bucket i counts the runs
+ * of 2^i to 2^(i+1) - 1 chars, so every possible run length has a bucket.
+ */
+constexpr std::size_t runLengthBuckets = 64;
+
+
+/**
+ * Counts of the runs in unencoded text, and of the eTokens they encode to
+ */
+struct RunStats {
+    // The number of runs, and so of eTokens
+    std::size_t runs{0};
+    // The number of runs in each power of two range of lengths
+    std::array<std::size_t, runLengthBuckets> histogram{};
+    // The number of long sequences (#-case a)
+    std::size_t longSequences{0};
+    // The number of runs of '#' chars (#-case b)
+    std::size_t markerRuns{0};
+    // The number of runs following a run of digits (#-case c)
+    std::size_t digitFollowingRuns{0};
+
+    /**
+     * Add the counts from another RunStats to these.
+     *
+     * @param other the counts to add
+     */
+    void merge(const RunStats& other);
+};
+
+
+/**
+ * Counts the runs in a sequence of chunks of unencoded text.
+ * Call write() for each chunk, then finish() once. Runs may span chunks.
+ */
+class RunCounter {
+public:
+    /**
+     * Count the runs in the next chunk of unencoded text.
+     *
+     * @param data pointer to the chunk
+     * @param length the number of chars in the chunk
+     */
+    void write(const char* data, std::size_t length);
+
+    /**
+     * Count the final run, and return the totals.
+     *
+     * @return the counts of all runs written
+     */
+    RunStats finish();
+
+private:
+    void addRun();
+
+    RunStats totals;
+    // The run at the end of the last chunk, which may continue into the next
+    char pendingChar{0};
+    std::size_t pendingCount{0};
+    bool prevRunDigit{false};
+};
+
+
+/**
+ * The stages of en/decoding a file, as timed by a StageTimer
+ */
+enum class Stage {
+    read,
+    encode,
+    decode,
+    write
+};
+
+
+/**
+ * The number of values of Stage
+ */
+constexpr std::size_t stageCount = 4;
+
+
+/**
+ * Statistics gathered over one or more en/decodes
+ */
+struct CodecStats {
+    // The number of bytes en/decoded, and of bytes produced
+    std::size_t bytesIn{0};
+    std::size_t bytesOut{0};
+    // The runs of the unencoded text
+    RunStats runs;
+    // The time in seconds spent in each stage, indexed by Stage
+    std::array<double, stageCount> stageSeconds{};
+    // The elapsed time in seconds from start to finish
+    double wallSeconds{0};
+
+    /**
+     * Add the statistics from another CodecStats to these. Stage times are
+     * summed, and the longer wall time is kept, as for work done at once.
+     *
+     * @param other the statistics to add
+     */
+    void merge(const CodecStats& other);
+};
+
+
+/**
+ * Adds the time from its construction to its destruction to a stage of a
+ * CodecStats. Does nothing if built with JRLE_STATS defined as 0.
+ */
+class StageTimer {
+public:
+#if JRLE_STATS
+    /**
+     * @param stats the statistics to add the time to, or null to time nothing
+     * @param stage the stage to add the time to
+     */
+    StageTimer(CodecStats* stats, Stage stage) :
+            stats{stats},
+            stage{stage},
+            start{stats != nullptr ? std::chrono::steady_clock::now()
+                : std::chrono::steady_clock::time_point{}} {}
+
+    ~StageTimer() {
+        if (stats != nullptr) {
+            const std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+            stats->stageSeconds[static_cast<std::size_t>(stage)] +=
+                elapsed.count();
+        }
+    }
+#else
+    StageTimer(CodecStats*, Stage) {}
+#endif
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+#if JRLE_STATS
+private:
+    CodecStats* stats;
+    Stage stage;
+    std::chrono::steady_clock::time_point start;
+#endif
+};
+
+
+/**
+ * Describe a CodecStats as a report for people, or as a JSON object.
+ * Only histogram buckets with runs in them are included.
+ *
+ * @param stats the statistics to describe
+ * @param json true for a JSON object, false for lines of text
+ * @return the report, ending with a newline
+ */
+std::string formatStats(const CodecStats& stats, bool json);
+
+#endif
@@ -0,0 +1,445 @@
+/**
+ * Streaming run-length encoder and decoder for jRLE.
+ * See jRLEStream.h for usage.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+#include "jRLEStream.h"
+#include "jRLECodec.h"
+#include "jRLEScan.h"
+
+#include <cctype>
+#include <cstring>
+#include <ios>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+
+/**
+ * @param out the std::ostream to write encoded text to
+ * @param bufferSize the size in bytes of the output buffer
+ */
+StreamEncoder::StreamEncoder(std::ostream& out, std::size_t bufferSize) :
+        out(out),
+        outBuffer(bufferSize < maxETokenLength ? maxETokenLength : bufferSize),
+        outPos{0},
+        totalIn{0},
+        totalOut{0},
+        runChar{0},
+        runLength{0},
+        prevRunDigit{false} {}
+
+
+/**
+ * Encode the next chunk of unencoded text.
+ * The last run in the chunk is held back until it is known to be complete.
+ *
+ * @param data pointer to the chunk of unencoded text
+ * @param length the number of bytes in the chunk
+ * @throw std::ios_base::failure if the output stream could not be written
+ */
+void StreamEncoder::write(const char* data, std::size_t length) {
+    totalIn += length;
+    const char* end = data + length;
+
+    while (data < end) {
+        // Extend the current run as far as this chunk allows
+        if (runLength != 0 && *data == runChar) {
+            const char* runEnd = findRunEnd(data, end);
+            runLength += runEnd - data;
+            data = runEnd;
+        // The current char starts a new run, so the current one is complete
+        } else {
+            if (runLength != 0) {
+                emitRun();
+            }
+            const char* runEnd = findRunEnd(data, end);
+            runChar = *data;
+            runLength = runEnd - data;
+            data = runEnd;
+        }
+    }
+}
+
+
+/**
+ * Encode the final run, and flush all buffered output to the ostream.
+ * No more chunks may be written afterwards.
+ *
+ * @throw std::ios_base::failure if the output stream could not be written
+ */
+void StreamEncoder::finish() {
+    if (runLength != 0) {
+        emitRun();
+        runLength = 0;
+    }
+    flush();
+    out.flush();
+}
+
+
+/**
+ * @return the number of unencoded bytes passed to write() so far
+ */
+std::size_t StreamEncoder::bytesIn() const {
+    return totalIn;
+}
+
+
+/**
+ * @return the number of encoded bytes produced so far, including
+ * any that are still buffered
+ */
+std::size_t StreamEncoder::bytesOut() const {
+    return totalOut;
+}
+
+
+/**
+ * Encode the current run into the output buffer, following the same rules
+ * as encodeTokens().
+ */
+void StreamEncoder::emitRun() {
+    // Ensure the whole eToken fits in the buffer
+    if (outBuffer.size() - outPos < maxETokenLength) {
+        flush();
+    }
+
+    std::size_t tokenLength = writeEToken(outBuffer.data() + outPos, runChar,
+        runLength, prevRunDigit);
+    outPos += tokenLength;
+    totalOut += tokenLength;
+
+    prevRunDigit = isdigit(static_cast<unsigned char>(runChar));
+}
+
+
+/**
+ * Write all buffered output to the ostream, and empty the buffer.
+ *
+ * @throw std::ios_base::failure if the output stream could not be written
+ */
+void StreamEncoder::flush() {
+    if (outPos == 0) {
+        return;
+    }
+    out.write(outBuffer.data(), outPos);
+    if (!out) {
+        throw std::ios_base::failure("Error writing encoded output stream");
+    }
+    outPos = 0;
+}
+
+
+/**
+ * @param out the std::ostream to write decoded text to
+ * @param bufferSize the size in bytes of the output buffer
+ */
+StreamDecoder::StreamDecoder(std::ostream& out, std::size_t bufferSize) :
+        out(out),
+        outBuffer(bufferSize == 0 ? 1 : bufferSize),
+        outPos{0},
+        totalIn{0},
+        totalOut{0},
+        state{State::normal},
+        count{0},
+        countPrefix{0},
+        countDigits{0} {}
+
+
+/**
+ * Decode the next chunk of encoded text.
+ * eTokens may be split across chunks at any position.
+ *
+ * @param data pointer to the chunk of encoded text
+ * @param length the number of bytes in the chunk
+ * @throw std::invalid_argument if the encoded text is invalid
+ * @throw std::ios_base::failure if the output stream could not be written
+ */
+void StreamDecoder::write(const char* data, std::size_t length) {
+    for (std::size_t i{0}; i < length; i++) {
+        step(data[i]);
+        totalIn++;
+    }
+}
+
+
+/**
+ * Decode any final eToken, and flush all buffered output to the ostream.
+ * No more chunks may be written afterwards.
+ *
+ * @throw std::invalid_argument if the encoded text ended mid-token
+ * @throw std::ios_base::failure if the output stream could not be written
+ */
+void StreamDecoder::finish() {
+    switch (state) {
+        // A char count was read, but not its char
+        case State::shortCount:
+            invalid("Missing token char");
+            break;
+
+        // A long sequence of digit chars ends the text.
+        // The last digit is the token char, all before it the count.
+        case State::longSeq:
+        case State::longSeqHash:
+            if (countDigits == 1) {
+                invalid("Missing token char");
+            } else if (countDigits > 1) {
+                emitRun(countPrefix, static_cast<char>('0' + count % 10));
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    state = State::normal;
+    countDigits = 0;
+    flush();
+    out.flush();
+}
+
+
+/**
+ * @return the number of encoded bytes passed to write() so far
+ */
+std::size_t StreamDecoder::bytesIn() const {
+    return totalIn;
+}
+
+
+/**
+ * @return the number of decoded bytes produced so far, including
+ * any that are still buffered
+ */
+std::size_t StreamDecoder::bytesOut() const {
+    return totalOut;
+}
+
+
+/**
+ * Advance the decoder by a single char of encoded text.
+ * This follows the same grammar as tokenizeEncoded().
+ *
+ * @param c the next char of encoded text
+ * @throw std::invalid_argument if the encoded text is invalid
+ */
+void StreamDecoder::step(char c) {
+    bool digit = isdigit(static_cast<unsigned char>(c));
+
+    switch (state) {
+        case State::normal:
+            // Start a new long sequence if one is marked
+            if (c == '#') {
+                state = State::longSeq;
+                countDigits = 0;
+            // The digit is the char count of a single-char token
+            } else if (digit) {
+                count = c - '0';
+                state = State::shortCount;
+            // A char without a char count is only allowed as LF on EOF,
+            // which can't be known until the next char arrives.
+            } else if (c != '\n') {
+                state = State::trailing;
+            }
+            break;
+
+        case State::shortCount:
+            emitRun(count, c);
+            state = State::normal;
+            break;
+
+        case State::longSeq:
+            if (digit) {
+                addDigit(c);
+            } else if (c == '#') {
+                state = State::longSeqHash;
+            // #-case a
+            } else if (countDigits != 0) {
+                emitRun(count, c);
+                state = State::normal;
+            // Unless current char is EOF with no char count, the count is
+            // missing.
+            } else if (c == '\n') {
+                state = State::normal;
+            } else {
+                invalid("Missing char count");
+            }
+            break;
+
+        case State::longSeqHash:
+            // #-case b
+            if (c == '#') {
+                if (countDigits == 0) {
+                    invalid("Missing char count");
+                }
+                emitRun(count, '#');
+                countDigits = 0;
+                state = State::longSeq;
+            } else {
+                // #-case a and/or #-case c: the previous # ends a token whose
+                // last digit is its token char, and starts the next long
+                // sequence. A # with no digits before it marks a sequence
+                // that has already started, so is ignored.
+                if (countDigits == 1) {
+                    invalid("Missing char count");
+                } else if (countDigits > 1) {
+                    emitRun(countPrefix, static_cast<char>('0' + count % 10));
+                }
+                countDigits = 0;
+                state = State::longSeq;
+                step(c);
+            }
+            break;
+
+        case State::trailing:
+            invalid("Non-digit char", totalIn - 1);
+            break;
+    }
+}
+
+
+/**
+ * Add a digit to the char count of the current long sequence.
+ *
+ * @param c the digit char to add
+ * @throw std::invalid_argument if the char count becomes too large
+ */
+void StreamDecoder::addDigit(char c) {
+    std::size_t value = c - '0';
+    if (countDigits == 0) {
+        countPrefix = 0;
+        count = value;
+    } else {
+        if (count > (std::numeric_limits<std::size_t>::max() - value) / 10) {
+            invalid("Char count too large");
+        }
+        countPrefix = count;
+        count = count * 10 + value;
+    }
+    countDigits++;
+}
+
+
+/**
+ * Write count copies of c to the output, flushing the buffer when it fills.
+ *
+ * @param count the number of chars in the run
+ * @param c the char to repeat
+ * @throw std::ios_base::failure if the output stream could not be written
+ */
+void StreamDecoder::emitRun(std::size_t count, char c) {
+    totalOut += count;
+    while (count > 0) {
+        if (outPos == outBuffer.size()) {
+            flush();
+        }
+        std::size_t n = outBuffer.size() - outPos;
+        if (n > count) {
+            n = count;
+        }
+        std::memset(outBuffer.data() + outPos, c, n);
+        outPos += n;
+        count -= n;
+    }
+}
+
+
+/**
+ * Write all buffered output to the ostream, and empty the buffer.
+ *
+ * @throw std::ios_base::failure if the output stream could not be written
+ */
+void StreamDecoder::flush() {
+    if (outPos == 0) {
+        return;
+    }
+    out.write(outBuffer.data(), outPos);
+    if (!out) {
+        throw std::ios_base::failure("Error writing decoded output stream");
+    }
+    outPos = 0;
+}
+
+
+/**
+ * Throw an exception describing invalid encoded text at the current position.
+ *
+ * @param reason description of the error
+ * @throw std::invalid_argument always
+ */
+void StreamDecoder::invalid(const char* reason) {
+    invalid(reason, totalIn);
+}
+
+
+/**
+ * Throw an exception describing invalid encoded text.
+ *
+ * @param reason description of the error
+ * @param position the position of the invalid char in the encoded text
+ * @throw std::invalid_argument always
+ */
+void StreamDecoder::invalid(const char* reason, std::size_t position) {
+    throw std::invalid_argument("Invalid encoded sequence. "
+        + std::string(reason) + " at position " + std::to_string(position));
+}
+
+
+/**
+ * Run-length encode everything readable from an istream, into an ostream.
+ * At most bufferSize bytes of input and output are held in memory.
+ *
+ * @param in the std::istream to read unencoded text from
+ * @param out the std::ostream to write encoded text to
+ * @param bufferSize the size in bytes of the input and output buffers
+ * @return the number of bytes read and written
+ * @throw std::ios_base::failure if either stream could not be used
+ */
+StreamTotals encodeStream(std::istream& in, std::ostream& out,
+        std::size_t bufferSize) {
+    StreamEncoder encoder{ out, bufferSize };
+    std::vector<char> inBuffer(bufferSize == 0 ? 1 : bufferSize);
+
+    while (in) {
+        in.read(inBuffer.data(), inBuffer.size());
+        encoder.write(inBuffer.data(), static_cast<std::size_t>(in.gcount()));
+    }
+    if (in.bad()) {
+        throw std::ios_base::failure("Error reading unencoded input stream");
+    }
+
+    encoder.finish();
+    return { encoder.bytesIn(), encoder.bytesOut() };
+}
+
+
+/**
+ * Run-length decode everything readable from an istream, into an ostream.
+ * At most bufferSize bytes of input and output are held in memory.
+ *
+ * @param in the std::istream to read encoded text from
+ * @param out the std::ostream to write decoded text to
+ * @param bufferSize the size in bytes of the input and output buffers
+ * @return the number of bytes read and written
+ * @throw std::invalid_argument if the encoded text is invalid
+ * @throw std::ios_base::failure if either stream could not be used
+ */
+StreamTotals decodeStream(std::istream& in, std::ostream& out,
+        std::size_t bufferSize) {
+    StreamDecoder decoder{ out, bufferSize };
+    std::vector<char> inBuffer(bufferSize == 0 ? 1 : bufferSize);
+
+    while (in) {
+        in.read(inBuffer.data(), inBuffer.size());
+        decoder.write(inBuffer.data(), static_cast<std::size_t>(in.gcount()));
+    }
+    if (in.bad()) {
+        throw std::ios_base::failure("Error reading encoded input stream");
+    }
+
+    decoder.finish();
+    return { decoder.bytesIn(), decoder.bytesOut() };
+}
@@ -0,0 +1,217 @@
+/**
+ * Streaming run-length encoder and decoder for jRLE.
+ *
+ * The functions in jRLE.h operate on whole strings, and so require the
+ * entire text - plus several tokenized copies of it - to be held in memory
+ * at once. The classes in this header instead consume their input in
+ * chunks of any size, and write their output through a fixed-size buffer
+ * to an std::ostream. Runs and partially read eTokens are carried over
+ * between chunks, so the input can be split at any byte.
+ *
+ * Memory use is bounded by the buffer size, regardless of input length.
+ *
+ * For example, to encode one file into another:
+ * std::ifstream in{ "in.txt", std::ios::binary };
+ * std::ofstream out{ "out.txt", std::ios::binary };
+ * encodeStream(in, out);
+ *
+ * Unlike readFile(), the streams operate on the exact bytes given, and do
+ * not append line endings to the input.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_STREAM_H
+#define JRLE_STREAM_H
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+
+/**
+ * The default size in bytes of the input and output buffers used for streaming
+ */
+constexpr std::size_t defaultStreamBufferSize = 1 << 16;
+
+
+/**
+ * The total number of bytes read and written by a streaming en/decode
+ */
+struct StreamTotals {
+    std::size_t bytesIn;
+    std::size_t bytesOut;
+};
+
+
+/**
+ * Run-length encode a sequence of chunks, writing the result to an ostream.
+ * Call write() for each chunk of unencoded text, then finish() once.
+ */
+class StreamEncoder {
+public:
+    /**
+     * @param out the std::ostream to write encoded text to
+     * @param bufferSize the size in bytes of the output buffer
+     */
+    explicit StreamEncoder(std::ostream& out,
+        std::size_t bufferSize = defaultStreamBufferSize);
+
+    /**
+     * Encode the next chunk of unencoded text.
+     * The last run in the chunk is held back until it is known to be complete.
+     *
+     * @param data pointer to the chunk of unencoded text
+     * @param length the number of bytes in the chunk
+     * @throw std::ios_base::failure if the output stream could not be written
+     */
+    void write(const char* data, std::size_t length);
+
+    /**
+     * Encode the final run, and flush all buffered output to the ostream.
+     * No more chunks may be written afterwards.
+     *
+     * @throw std::ios_base::failure if the output stream could not be written
+     */
+    void finish();
+
+    /**
+     * @return the number of unencoded bytes passed to write() so far
+     */
+    std::size_t bytesIn() const;
+
+    /**
+     * @return the number of encoded bytes produced so far, including
+     * any that are still buffered
+     */
+    std::size_t bytesOut() const;
+
+private:
+    void emitRun();
+    void flush();
+
+    std::ostream& out;
+    std::vector<char> outBuffer;
+    std::size_t outPos;
+    std::size_t totalIn;
+    std::size_t totalOut;
+    // The run currently being read. runLength 0 indicates no run.
+    char runChar;
+    std::size_t runLength;
+    // Whether the previously emitted run consisted of digits (#-case c)
+    bool prevRunDigit;
+};
+
+
+/**
+ * Run-length decode a sequence of chunks, writing the result to an ostream.
+ * Call write() for each chunk of encoded text, then finish() once.
+ */
+class StreamDecoder {
+public:
+    /**
+     * @param out the std::ostream to write decoded text to
+     * @param bufferSize the size in bytes of the output buffer
+     */
+    explicit StreamDecoder(std::ostream& out,
+        std::size_t bufferSize = defaultStreamBufferSize);
+
+    /**
+     * Decode the next chunk of encoded text.
+     * eTokens may be split across chunks at any position.
+     *
+     * @param data pointer to the chunk of encoded text
+     * @param length the number of bytes in the chunk
+     * @throw std::invalid_argument if the encoded text is invalid
+     * @throw std::ios_base::failure if the output stream could not be written
+     */
+    void write(const char* data, std::size_t length);
+
+    /**
+     * Decode any final eToken, and flush all buffered output to the ostream.
+     * No more chunks may be written afterwards.
+     *
+     * @throw std::invalid_argument if the encoded text ended mid-token
+     * @throw std::ios_base::failure if the output stream could not be written
+     */
+    void finish();
+
+    /**
+     * @return the number of encoded bytes passed to write() so far
+     */
+    std::size_t bytesIn() const;
+
+    /**
+     * @return the number of decoded bytes produced so far, including
+     * any that are still buffered
+     */
+    std::size_t bytesOut() const;
+
+private:
+    // The position of the decoder within the eToken currently being read
+    enum class State {
+        // Between tokens, outside of a long sequence
+        normal,
+        // Read a single digit char count, the token char is next
+        shortCount,
+        // Inside a long sequence, reading its char count
+        longSeq,
+        // Read a # inside a long sequence, the next char decides its meaning
+        longSeqHash,
+        // Read a char with no char count. Only valid at the end of the text.
+        trailing
+    };
+
+    void step(char c);
+    void addDigit(char c);
+    void emitRun(std::size_t count, char c);
+    void flush();
+    [[noreturn]] void invalid(const char* reason);
+    [[noreturn]] void invalid(const char* reason, std::size_t position);
+
+    std::ostream& out;
+    std::vector<char> outBuffer;
+    std::size_t outPos;
+    std::size_t totalIn;
+    std::size_t totalOut;
+    State state;
+    // Value of all char count digits read for the current token
+    std::size_t count;
+    // Value of all char count digits read, except for the last
+    std::size_t countPrefix;
+    // The number of char count digits read for the current token
+    std::size_t countDigits;
+};
+
+
+/**
+ * Run-length encode everything readable from an istream, into an ostream.
+ * At most bufferSize bytes of input and output are held in memory.
+ *
+ * @param in the std::istream to read unencoded text from
+ * @param out the std::ostream to write encoded text to
+ * @param bufferSize the size in bytes of the input and output buffers
+ * @return the number of bytes read and written
+ * @throw std::ios_base::failure if either stream could not be used
+ */
+StreamTotals encodeStream(std::istream& in, std::ostream& out,
+    std::size_t bufferSize = defaultStreamBufferSize);
+
+
+/**
+ * Run-length decode everything readable from an istream, into an ostream.
+ * At most bufferSize bytes of input and output are held in memory.
+ *
+ * @param in the std::istream to read encoded text from
+ * @param out the std::ostream to write decoded text to
+ * @param bufferSize the size in bytes of the input and output buffers
+ * @return the number of bytes read and written
+ * @throw std::invalid_argument if the encoded text is invalid
+ * @throw std::ios_base::failure if either stream could not be used
+ */
+StreamTotals decodeStream(std::istream& in, std::ostream& out,
+    std::size_t bufferSize = defaultStreamBufferSize);
+
+#endif
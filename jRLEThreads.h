@@ -0,0 +1,319 @@
+/**
+ * Threading utilities shared by the multithreaded parts of jRLE.
+ * This header is internal, and is not included by jRLE.h.
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_THREADS_H
+#define JRLE_THREADS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @param threads a requested number of threads, where 0 means one per
+ *                hardware thread
+ * @return the number of threads to use, at least 1
+ */
+inline unsigned resolveThreadCount(unsigned threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    return threads == 0 ? 1 : threads;
+}
+
+
+/**
+ * Run a function on count threads at once, and wait for all of them.
+ * If any thread throws, the first exception is rethrown once all have ended.
+ *
+ * @param count the number of threads to run
+ * @param work function to call on each thread, with the thread's index
+ */
+template <typename Function>
+void runOnThreads(std::size_t count, Function work) {
+    // Don't start a thread just to wait for it
+    if (count == 1) {
+        work(std::size_t{0});
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(count);
+    std::vector<std::thread> workers;
+    workers.reserve(count);
+
+    for (std::size_t i{0}; i < count; i++) {
+        workers.emplace_back([&work, &errors, i]() {
+            try {
+                work(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+
+/**
+ * Run a function once for each of count items, spread across a pool of
+ * threads, and wait for all of them. Items are dealt out to the threads in
+ * turn, and each thread takes its own items from the front of its queue.
+ * A thread that runs out steals from the back of another thread's queue, so
+ * one slow item does not hold up the items queued behind it.
+ * If any item throws, no new items are started, and the first exception is
+ * rethrown once all threads have ended.
+ *
+ * @param count the number of items
+ * @param threads the number of threads to use, at least 1
+ * @param work function to call for each item, with the item's index and the
+ *             index of the thread running it. Items are started in order of
+ *             index on each thread, so should be ordered longest first.
+ */
+template <typename Function>
+void runWorkStealing(std::size_t count, unsigned threads, Function work) {
+    if (count < threads) {
+        threads = static_cast<unsigned>(count);
+    }
+    if (threads <= 1) {
+        for (std::size_t i{0}; i < count; i++) {
+            work(i, std::size_t{0});
+        }
+        return;
+    }
+
+    // Each thread's queue of items, behind its own lock
+    struct Queue {
+        std::mutex lock;
+        std::deque<std::size_t> items;
+    };
+    std::vector<Queue> queues(threads);
+    for (std::size_t i{0}; i < count; i++) {
+        queues[i % threads].items.push_back(i);
+    }
+
+    // Take the next item for a thread, from its own queue or another's
+    auto take = [&queues, threads](std::size_t self, std::size_t& item) {
+        for (unsigned offset{0}; offset < threads; offset++) {
+            Queue& queue = queues[(self + offset) % threads];
+            std::lock_guard<std::mutex> guard{ queue.lock };
+            if (queue.items.empty()) {
+                continue;
+            }
+            if (offset == 0) {
+                item = queue.items.front();
+                queue.items.pop_front();
+            } else {
+                item = queue.items.back();
+                queue.items.pop_back();
+            }
+            return true;
+        }
+        return false;
+    };
+
+    std::mutex errorLock;
+    std::exception_ptr error;
+    runOnThreads(threads, [&](std::size_t self) {
+        std::size_t item;
+        while (take(self, item)) {
+            {
+                std::lock_guard<std::mutex> guard{ errorLock };
+                if (error) {
+                    return;
+                }
+            }
+            try {
+                work(item, self);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard{ errorLock };
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+
+/**
+ * A bounded, lock-free queue between exactly one producer thread and one
+ * consumer thread. tryPush() and tryPop() never block: a full or empty
+ * queue is reported, and the caller decides how to wait. push() and pop()
+ * wait for room or for an item, spinning briefly and then sleeping, so a
+ * side left waiting on a slow peer uses no CPU. Items themselves always
+ * pass through the ring without a lock. The lock is only taken to sleep,
+ * and to wake a side that is asleep, which is only ever the case once it
+ * has found the queue full or empty.
+ */
+template <typename T>
+class SpscRing {
+public:
+    /**
+     * @param capacity the minimum number of items the queue can hold
+     */
+    explicit SpscRing(std::size_t capacity) {
+        std::size_t size{1};
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    /**
+     * Add an item to the back of the queue. Only call from the producer.
+     *
+     * @param item the item to add
+     * @return false if the queue is full, and the item was not added
+     */
+    bool tryPush(const T& item) {
+        const std::size_t back = tail.load(std::memory_order_relaxed);
+        if (back - head.load(std::memory_order_acquire) == slots.size()) {
+            return false;
+        }
+        slots[back & mask] = item;
+        tail.store(back + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Remove the item at the front of the queue. Only call from the consumer.
+     *
+     * @param item set to the removed item
+     * @return false if the queue is empty, and item was not set
+     */
+    bool tryPop(T& item) {
+        const std::size_t front = head.load(std::memory_order_relaxed);
+        if (front == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = slots[front & mask];
+        head.store(front + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Add an item to the back of the queue, waiting for room if it is full.
+     * Only call from the producer.
+     *
+     * @param item the item to add
+     * @param stop set to abandon waiting, followed by a call to wake()
+     * @return false if stop was set before the item could be added
+     */
+    bool push(const T& item, const std::atomic<bool>& stop) {
+        if (!waitUntil([&] { return tryPush(item); }, stop)) {
+            return false;
+        }
+        wakeSleeper();
+        return true;
+    }
+
+    /**
+     * Remove the item at the front of the queue, waiting for one if it is
+     * empty. Only call from the consumer.
+     *
+     * @param item set to the removed item
+     * @param stop set to abandon waiting, followed by a call to wake()
+     * @return false if stop was set before an item could be removed
+     */
+    bool pop(T& item, const std::atomic<bool>& stop) {
+        if (!waitUntil([&] { return tryPop(item); }, stop)) {
+            return false;
+        }
+        wakeSleeper();
+        return true;
+    }
+
+    /**
+     * Wake both sides if they are waiting in push() or pop(), so that they
+     * see that their stop flag has been set. May be called from any thread.
+     */
+    void wake() {
+        { std::lock_guard<std::mutex> guard{ sleepLock }; }
+        wakeup.notify_all();
+    }
+
+private:
+    // The number of times to retry before sleeping. Enough to ride out a
+    // peer that is about to catch up, without burning a core on one that
+    // is not.
+    static constexpr unsigned spinLimit = 64;
+
+    /**
+     * Retry an operation on the queue until it succeeds, spinning briefly,
+     * then sleeping until the other side makes progress.
+     *
+     * @param attempt tries the operation once, returning true if it did
+     * @param stop set to abandon waiting
+     * @return false if stop was set before the operation succeeded
+     */
+    template <typename Attempt>
+    bool waitUntil(Attempt attempt, const std::atomic<bool>& stop) {
+        for (unsigned spin{0}; spin < spinLimit; spin++) {
+            if (attempt()) {
+                return true;
+            } else if (stop.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock{ sleepLock };
+        sleepers.fetch_add(1, std::memory_order_relaxed);
+        // Pairs with the fence in wakeSleeper(): either the attempt below
+        // sees the other side's progress, or the other side sees a sleeper
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool succeeded{false};
+        wakeup.wait(lock, [&] {
+            succeeded = attempt();
+            return succeeded || stop.load(std::memory_order_relaxed);
+        });
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+        return succeeded;
+    }
+
+    /**
+     * Wake the other side after a push or pop, if it is asleep waiting for
+     * one. It only sleeps once it has found the queue full or empty, so this
+     * costs nothing while both sides keep up.
+     */
+    void wakeSleeper() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) != 0) {
+            wake();
+        }
+    }
+
+    std::vector<T> slots;
+    std::size_t mask;
+    // Lets a waiting side sleep until the other makes progress
+    std::mutex sleepLock;
+    std::condition_variable wakeup;
+    std::atomic<unsigned> sleepers{0};
+    // The number of items ever popped and pushed. Each is written by one
+    // side only, and kept on its own cache line so the sides do not contend.
+    alignas(64) std::atomic<std::size_t> head{0};
+    alignas(64) std::atomic<std::size_t> tail{0};
+};
+
+#endif
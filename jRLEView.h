@@ -0,0 +1,219 @@
+/**
+ * Lazy decoding of run-length encoded text for jRLE, for consumers that
+ * scan the decoded text once without needing all of it at once.
+ *
+ * decodeTokens() and decode() materialize the whole decoded text before it
+ * can be read. forEachRun() instead passes each run to a callback as a
+ * count and a char, which costs the same whatever the length of the run,
+ * so consumers that can work on whole runs, such as histograms and byte
+ * counts, never expand them at all. DecodedView iterates over the decoded
+ * chars one at a time, decoding each run only as it is reached, for
+ * consumers that need every char. Both use constant memory.
+ *
+ * For example, to count the chars of each value in encoded text:
+ * std::array<std::size_t, 256> histogram{};
+ * forEachRun(encoded, [&](std::size_t count, char c) {
+ *     histogram[static_cast<unsigned char>(c)] += count;
+ * });
+ *
+ * Or to find the first line break in the decoded text:
+ * DecodedView view{ encoded };
+ * auto found = std::find(view.begin(), view.end(), '\n');
+ *
+ * Written by Jasper Law 2020
+ * https://github.com/Trimatix/cpp-run-length-encoder
+ */
+
+#ifndef JRLE_VIEW_H
+#define JRLE_VIEW_H
+
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+
+#include "jRLEPolicy.h"
+
+
+/**
+ * Pass each run described by run-length encoded text to a consumer, in
+ * order, without decoding the runs. The consumer is called as
+ * consumer(count, c), and may return a bool, where false stops reading
+ * early.
+ *
+ * @param in the encoded text to read
+ * @param consumer called with the char count and char of each run
+ * @return true if every run was read, false if the consumer stopped early
+ * @throw std::invalid_argument if the encoded text is invalid, once the
+ *        runs before the error have been passed to the consumer
+ */
+template <typename Consumer>
+bool forEachRun(std::string_view in, Consumer&& consumer) {
+    return DefaultRLE::forEachRun(in, consumer);
+}
+
+
+/**
+ * Pass each run described by run-length encoded text to a consumer, in
+ * order, without decoding the runs, reporting an error instead of throwing
+ * it. The consumer is called as consumer(count, c), and may return a bool,
+ * where false stops reading early.
+ *
+ * @param in the encoded text to read
+ * @param consumer called with the char count and char of each run
+ * @param error set to an invalidEncoding error if the encoded text is
+ *              invalid. Left unchanged otherwise.
+ * @return true if every run was read, false if the consumer stopped early
+ *         or the encoded text is invalid
+ */
+template <typename Consumer>
+bool forEachRun(std::string_view in, Consumer&& consumer,
+        CodecError& error) {
+    return DefaultRLE::forEachRun(in, consumer, error);
+}
+
+
+/**
+ * A range over the decoded text of run-length encoded text, decoded lazily
+ * as it is iterated. The view holds only the encoded text, so is cheap to
+ * copy, and each iterator holds only its position within it.
+ */
+class DecodedView {
+public:
+    /**
+     * Iterates once over decoded chars, reading the next run from the
+     * encoded text only once the last has been passed.
+     */
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = char;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const char*;
+        using reference = const char&;
+
+        /**
+         * Create an iterator past the end of any decoded text.
+         */
+        iterator() = default;
+
+        /**
+         * @param text the encoded text to decode. Must outlive the iterator.
+         * @throw std::invalid_argument if the encoded text is invalid
+         *        before its first run
+         */
+        explicit iterator(std::string_view text) : text{ text } {
+            nextRun();
+        }
+
+        reference operator*() const {
+            return c;
+        }
+
+        pointer operator->() const {
+            return &c;
+        }
+
+        /**
+         * Move to the next decoded char, reading the next run if the last
+         * has been passed.
+         *
+         * @throw std::invalid_argument if the encoded text is invalid
+         */
+        iterator& operator++() {
+            if (--remaining == 0) {
+                nextRun();
+            }
+            return *this;
+        }
+
+        /**
+         * @throw std::invalid_argument if the encoded text is invalid
+         */
+        iterator operator++(int) {
+            iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        /**
+         * Skip the rest of the current run, moving to the first char of the
+         * next, so that a consumer can pass over long runs in one step.
+         *
+         * @return the number of chars skipped
+         * @throw std::invalid_argument if the encoded text is invalid
+         */
+        std::size_t skipRun() {
+            const std::size_t skipped = remaining;
+            if (remaining != 0) {
+                nextRun();
+            }
+            return skipped;
+        }
+
+        /**
+         * @return the number of chars left in the current run, including
+         *         the current char, or 0 at the end
+         */
+        std::size_t runRemaining() const {
+            return remaining;
+        }
+
+        bool operator==(const iterator& other) const {
+            return remaining == other.remaining
+                && (remaining == 0 || pos == other.pos);
+        }
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        std::string_view text;
+        // The position in text after the current run
+        std::size_t pos{0};
+        bool longSeq{false};
+        // The char of the current run, and how many of it are left
+        char c{0};
+        std::size_t remaining{0};
+
+        /**
+         * Read runs until one with chars is found, or the text ends.
+         *
+         * @throw std::invalid_argument if the encoded text is invalid
+         */
+        void nextRun() {
+            std::size_t count{0};
+            while (count == 0
+                    && DefaultRLE::readRun(text, pos, longSeq, count, c)) {
+            }
+            remaining = count;
+        }
+    };
+
+    /**
+     * @param encoded the encoded text to decode. Must outlive the view and
+     *                its iterators.
+     */
+    explicit DecodedView(std::string_view encoded) : encoded{ encoded } {}
+
+    /**
+     * @return an iterator to the first decoded char
+     * @throw std::invalid_argument if the encoded text is invalid before
+     *        its first run
+     */
+    iterator begin() const {
+        return iterator{ encoded };
+    }
+
+    /**
+     * @return an iterator past the last decoded char
+     */
+    iterator end() const {
+        return iterator{};
+    }
+
+private:
+    std::string_view encoded;
+};
+
+#endif